@@ -16,10 +16,26 @@
 #define _USE_MATH_DEFINES
 #define _CRT_SECURE_NO_WARNINGS
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * @typedef vertex_t
+ * @brief Type of the stored vertex coordinates
+ *
+ * double by default. Building with VERTEX_FLOAT defined stores float instead,
+ * which halves the memory of the vertex matrix and lets OpenGL take the
+ * vertices without converting them. Parsing, the bounding box and all
+ * transformation math stay in double; only the stored result is rounded.
+ */
+#ifdef VERTEX_FLOAT
+typedef float vertex_t;
+#else
+typedef double vertex_t;
+#endif  // VERTEX_FLOAT
+
 /**
  * @struct matr
  * @brief Matrix structure
@@ -27,7 +43,7 @@
  * This structure represents a two-dimensional matrix.
  */
 typedef struct matr {
-  double *matrix;
+  vertex_t *matrix;
   size_t rows;
   size_t colums;
 } matrix_t;
@@ -43,12 +59,72 @@ typedef struct poly {
   size_t colums;
 } polygon_t;
 
+/**
+ * @struct arena_blk
+ * @brief Block of memory owned by an arena
+ *
+ * The data area follows the header in the same allocation.
+ */
+typedef struct arena_blk {
+  struct arena_blk *next;
+  size_t size;
+  size_t used;
+} arena_block;
+
+/**
+ * @struct mem_arena
+ * @brief Growable arena allocator
+ *
+ * reserved is the size of all blocks, used the part of it handed out since
+ * the last reset and high_water the largest value used has reached. A zeroed
+ * structure is an empty arena.
+ */
+typedef struct mem_arena {
+  arena_block *blocks;
+  size_t reserved;
+  size_t used;
+  size_t high_water;
+} arena_t;
+
+/**
+ * @struct quantized_vert
+ * @brief Vertex coordinates stored as 16-bit step counts
+ *
+ * Coordinate k of vertex i is origin[k] + positions[i * 3 + k] * step[k].
+ * Row 0 is unused and decodes to origin. max_error is the largest difference
+ * between a decoded and an original coordinate.
+ */
+typedef struct quantized_vert {
+  int16_t *positions;
+  double origin[3];
+  double step[3];
+  double max_error;
+} quantized_t;
+
 /**
  * @struct data_obj
  * @brief Data Object Structure
  *
  * This structure contains information about a 3D object, including vertices,
  * polygons, and edges.
+ *
+ * The all_edges_count vertex indices of all polygons are stored back to back
+ * in index_array. Polygon i uses the entries from offset_array[i] up to
+ * offset_array[i + 1], so offset_array has polygon_count + 1 entries. Use
+ * get_polygon() to view a single polygon.
+ *
+ * build_edges() fills edge_array with the edges_count segments of the
+ * wireframe as pairs of vertex indices; both are zero until it is called.
+ *
+ * The arrays are allocated from arena, or point into mapping when the model
+ * was loaded from the binary cache. A zeroed structure is an empty object;
+ * parsing into an object that already holds a model reuses its arena.
+ *
+ * bbox_min, bbox_max and centroid describe the vertices as they were read
+ * from the file and are all zero for a model without vertices.
+ *
+ * After quantize_object() the vertex matrix pointer is NULL and the vertices
+ * are kept in quantized instead; get_vertex() reads either storage.
  */
 typedef struct data_obj {
   size_t vertex_count;
@@ -56,7 +132,16 @@ typedef struct data_obj {
   size_t polygon_count;
   size_t edges_count;
   size_t all_edges_count;
-  polygon_t *polygon_array;
+  unsigned int *index_array;
+  size_t *offset_array;
+  unsigned int *edge_array;
+  arena_t arena;
+  void *mapping;
+  size_t mapping_size;
+  double bbox_min[3];
+  double bbox_max[3];
+  double centroid[3];
+  quantized_t quantized;
 } data_object;
 
 /**
@@ -67,12 +152,109 @@ typedef struct data_obj {
  */
 enum status { OK, ERROR };
 
+/**
+ * @enum read_mode
+ * @brief How parse_obj() reads the file
+ *
+ * READ_AUTO maps regular files into memory and uses buffered reads for pipes
+ * and stdin, READ_MMAP fails on anything that cannot be mapped and
+ * READ_BUFFERED always reads the file with getline().
+ */
+enum read_mode { READ_AUTO, READ_MMAP, READ_BUFFERED };
+
+/**
+ * @enum cache_mode
+ * @brief Whether load_obj() uses the binary model cache
+ */
+enum cache_mode { CACHE_AUTO, CACHE_OFF };
+
+/**
+ * @struct parser_opt
+ * @brief Parser options
+ *
+ * A zeroed structure selects the defaults. threads limits how many threads
+ * parse a mapped file: 0 uses one per CPU core and 1 parses serially. cache
+ * and cache_dir are used by load_obj() only; a NULL cache_dir selects the
+ * per-user cache directory.
+ *
+ * progress, if set, is called with the number of bytes parsed so far and the
+ * file size, or 0 when the size is not known. It may be called from several
+ * parser threads at once. A non-zero return value cancels the parse, which
+ * then fails with ERROR and leaves the data_object untouched.
+ */
+typedef struct parser_opt {
+  int read_mode;
+  int threads;
+  int cache;
+  const char *cache_dir;
+  int (*progress)(void *context, size_t done, size_t total);
+  void *progress_context;
+} parser_options;
+
+/**
+ * @struct vertex_soa
+ * @brief Vertex coordinates in a structure-of-arrays layout
+ *
+ * Vertex i of the object is (x[i], y[i], z[i]); the zero row of the vertex
+ * matrix is not included. Filled by soa_load().
+ */
+typedef struct vertex_soa {
+  double *x;
+  double *y;
+  double *z;
+  size_t count;
+} vertex_soa;
+
+/**
+ * @enum simd_level
+ * @brief Instruction set used by the soa_*() kernels
+ */
+enum simd_level { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 };
+
+/**
+ * @struct render_set
+ * @brief Settings of soft_render(), named as in settings.ini
+ *
+ * projection is 1 for central and 0 for parallel projection, type_line is 1
+ * for solid and 0 for dashed lines, type_point is 0 for no points, 1 for
+ * round and 2 for square ones. Colors are red, green and blue from 0 to 1.
+ * A zeroed threads uses one thread per CPU core.
+ */
+typedef struct render_set {
+  int width;
+  int height;
+  int projection;
+  int type_line;
+  int type_point;
+  double thickness;
+  double size_points;
+  double line_color[3];
+  double points_color[3];
+  double background_color[3];
+  const double *model_matrix;  ///< Column-major 4x4, NULL for identity
+  double extent;               ///< Size of the view volume, see model_extent()
+  int threads;                 ///< Threads that render the tiles
+} render_settings;
+
 int parser(char *file_name, data_object *data_obj);
-void count_vert_pol(FILE *file, data_object *data_obj);
+int parse_obj(char *file_name, data_object *data_obj,
+              const parser_options *options);
+int load_obj(char *file_name, data_object *data_obj,
+             const parser_options *options, int *from_cache);
 void memory_free_matrix(matrix_t *old_matrix);
 void memory_free(data_object *data_obj);
+void memory_reset(data_object *data_obj);
 int create_matrix(size_t rows, size_t colums, matrix_t *new_matrix);
 int create_polygon(size_t col, polygon_t *new_polygon);
+polygon_t get_polygon(const data_object *data_obj, size_t index);
+size_t vertex_bytes(size_t vertex_count);
+int quantize_object(data_object *data_obj);
+void get_vertex(const data_object *data_obj, size_t index, double *xyz);
+size_t model_memory(const data_object *data_obj);
+double model_extent(const data_object *data_obj);
+int build_edges(data_object *data_obj);
+int soft_render(const data_object *data_obj, const render_settings *settings,
+                unsigned char *pixels);
 void memory_free_polygon(polygon_t *old_polygon);
 void move_x(data_object *data_obj, double new_value, double old_value);
 void move_y(data_object *data_obj, double new_value, double old_value);
@@ -81,5 +263,34 @@ void rotate_x(data_object *data_obj, double new_angle, double old_angle);
 void rotate_y(data_object *data_obj, double new_angle, double old_angle);
 void rotate_z(data_object *data_obj, double new_angle, double old_angle);
 void scale(data_object *data_obj, int new_scale, int old_scale);
+void affine_set_parallel(int threads, size_t min_vertices);
+void model_identity(double *matrix);
+void model_move(double *matrix, double dx, double dy, double dz);
+void model_rotate_x(double *matrix, double angle);
+void model_rotate_y(double *matrix, double angle);
+void model_rotate_z(double *matrix, double angle);
+void model_scale(double *matrix, double factor);
+void model_transform(const double *matrix, const double *point,
+                     double *result);
+int simd_level(void);
+int simd_set_level(int level);
+int soa_load(data_object *data_obj, vertex_soa *soa);
+void soa_store(const vertex_soa *soa, data_object *data_obj);
+void soa_move(vertex_soa *soa, double dx, double dy, double dz);
+void soa_rotate_x(vertex_soa *soa, double angle);
+void soa_rotate_y(vertex_soa *soa, double angle);
+void soa_rotate_z(vertex_soa *soa, double angle);
+void soa_scale(vertex_soa *soa, double factor);
+void soa_transform(vertex_soa *soa, const double *matrix);
+void *arena_alloc(arena_t *arena, size_t size);
+void arena_reset(arena_t *arena);
+void arena_release(arena_t *arena);
+int parallel_threads(void);
+void parallel_for(size_t tasks, int threads,
+                  void (*task)(void *context, size_t index), void *context);
+int scan_double(const char **pos, const char *end, double *value);
+int scan_index(const char **pos, const char *end, long *value);
+int scan_face_vertex(const char **pos, const char *end, long *v, long *vt,
+                     long *vn);
 
 #endif  // S21_3D_VIEVER_H
@@ -0,0 +1,108 @@
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QThread>
+#include <cmath>
+#include <cstdio>
+
+#include "../QtGifImage/src/gifimage/qgifimage.h"
+
+extern "C" {
+#include "../3DViever.h"
+}
+
+#define BENCH_GRID 300
+#define BENCH_FRAMES 200
+#define BENCH_GROUP 32
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+
+static int write_grid(const char *file_name, int grid) {
+  FILE *file = fopen(file_name, "w");
+  if (!file) return ERROR;
+  for (int y = 0; y <= grid; y++)
+    for (int x = 0; x <= grid; x++)
+      fprintf(file, "v %g %g %g\n", (double)x / grid - 0.5,
+              (double)y / grid - 0.5,
+              0.1 * sin(x * 0.05) * cos(y * 0.05));
+  for (int y = 0; y < grid; y++)
+    for (int x = 0; x < grid; x++) {
+      int v = y * (grid + 1) + x + 1;
+      fprintf(file, "f %d %d %d %d\n", v, v + 1, v + grid + 2, v + grid + 1);
+    }
+  fclose(file);
+  return OK;
+}
+
+struct bench_result {
+  double render_ms = 0;
+  double encode_ms = 0;
+  QByteArray gif;
+};
+
+// Кадры рендерятся группами: 200 кадров 1080p в RGBA заняли бы 1.6 ГБ
+static bench_result run(const data_object *data_obj, int threads) {
+  bench_result result;
+  double matrix[16];
+  render_settings settings = {
+      BENCH_WIDTH, BENCH_HEIGHT, 1, 1, 2, 1, 3, {1, 1, 0}, {0, 0, 1},
+      {0, 0, 0}, matrix, model_extent(data_obj), 0};
+  QBuffer buffer(&result.gif);
+  buffer.open(QIODevice::WriteOnly);
+  QGifImage gif(QSize(BENCH_WIDTH, BENCH_HEIGHT));
+  gif.setThreadCount(threads);
+  gif.open(&buffer);
+  QElapsedTimer timer;
+  for (int first = 0; first < BENCH_FRAMES; first += BENCH_GROUP) {
+    QList<QImage> group;
+    timer.start();
+    for (int frame = first; frame < first + BENCH_GROUP && frame < BENCH_FRAMES;
+         frame++) {
+      model_identity(matrix);
+      model_rotate_x(matrix, -60);
+      model_rotate_z(matrix, 360.0 * frame / BENCH_FRAMES);
+      QImage image(BENCH_WIDTH, BENCH_HEIGHT, QImage::Format_RGBA8888);
+      soft_render(data_obj, &settings, image.bits());
+      group.append(image);
+    }
+    result.render_ms += timer.nsecsElapsed() / 1e6;
+    timer.start();
+    gif.writeFrames(group, 100);
+    result.encode_ms += timer.nsecsElapsed() / 1e6;
+  }
+  timer.start();
+  gif.close();
+  result.encode_ms += timer.nsecsElapsed() / 1e6;
+  return result;
+}
+
+int main(int argc, char **argv) {
+  const char *grid_name = "gif_bench_grid.obj";
+  int from_file = argc > 1;
+  data_object data_obj = {};
+  if (!from_file && write_grid(grid_name, BENCH_GRID) != OK) return 1;
+  if (parser(from_file ? argv[1] : (char *)grid_name, &data_obj) != OK ||
+      build_edges(&data_obj) != OK)
+    return 1;
+  if (!from_file) remove(grid_name);
+  int cores = QThread::idealThreadCount();
+  printf("%zu edges, %d frames %dx%d, %d CPU cores\n", data_obj.edges_count,
+         BENCH_FRAMES, BENCH_WIDTH, BENCH_HEIGHT, cores);
+  int counts[] = {1, 2, 4, 8, cores};
+  bench_result serial;
+  for (int i = 0; i < 5; i++) {
+    if (i == 4 && (cores == 1 || cores == 2 || cores == 4 || cores == 8))
+      continue;
+    if (i > 0 && counts[i] > cores) continue;
+    bench_result result = run(&data_obj, counts[i]);
+    if (i == 0) serial = result;
+    bool same = result.gif == serial.gif;
+    printf("%2d thr encode %8.1f ms %7.1f frames/s %6.2fx  render %8.1f ms  "
+           "%.1f MB%s\n",
+           counts[i], result.encode_ms, BENCH_FRAMES / (result.encode_ms / 1e3),
+           serial.encode_ms / result.encode_ms, result.render_ms,
+           result.gif.size() / 1e6, same ? "" : "  output differs");
+  }
+  memory_free(&data_obj);
+  return 0;
+}
@@ -28,6 +28,8 @@
 #include <QFile>
 #include <QImage>
 #include <QScopedPointer>
+#include <QThread>
+#include <QThreadPool>
 
 #include "qgifimage_p.h"
 
@@ -42,12 +44,35 @@ int readFromIODevice(GifFileType *gifFile, GifByteType *data, int maxSize) {
   return static_cast<QIODevice *>(gifFile->UserData)
       ->read(reinterpret_cast<char *>(data), maxSize);
 }
+
+// Collects the bytes of one encoded frame. The trailer written by
+// EGifCloseFile() is dropped, so that the frames can be concatenated.
+struct FrameBuffer {
+  QByteArray bytes;
+  bool closing;
+};
+
+int writeToFrameBuffer(GifFileType *gifFile, const GifByteType *data,
+                       int maxSize) {
+  FrameBuffer *buffer = static_cast<FrameBuffer *>(gifFile->UserData);
+  if (!buffer->closing)
+    buffer->bytes.append(reinterpret_cast<const char *>(data), maxSize);
+  return maxSize;
+}
 }  // namespace
 
 QGifImagePrivate::QGifImagePrivate(QGifImage *p)
-    : loopCount(0), defaultDelayTime(1000), q_ptr(p) {}
-
-QGifImagePrivate::~QGifImagePrivate() {}
+    : loopCount(0),
+      defaultDelayTime(1000),
+      threadCount(0),
+      streamFile(0),
+      streamDevice(0),
+      streamOwnsDevice(false),
+      streamScreenWritten(false),
+      streamFrameCount(0),
+      q_ptr(p) {}
+
+QGifImagePrivate::~QGifImagePrivate() { closeStream(); }
 
 QVector<QRgb> QGifImagePrivate::colorTableFromColorMapObject(
     ColorMapObject *colorMap, int transColorIndex) const {
@@ -233,86 +258,271 @@ bool QGifImagePrivate::save(QIODevice *device) const {
     return false;
   }
 
-  QSize _canvasSize = getCanvasSize();
-  gifFile->SWidth = _canvasSize.width();
-  gifFile->SHeight = _canvasSize.height();
-  gifFile->SColorResolution = 8;
-  if (!globalColorTable.isEmpty()) {
-    gifFile->SColorMap = colorTableToColorMapObject(globalColorTable);
-    int idx = globalColorTable.indexOf(bgColor.rgba());
-    gifFile->SBackGroundColor = idx == -1 ? 0 : idx;
-  }
+  // Frames are encoded straight from frameInfos, without copying all of
+  // them into SavedImages first.
+  bool ok = writeScreen(gifFile, getCanvasSize()) &&
+            writeFrames(gifFile, device, frameInfos, true);
 
-  gifFile->ImageCount = frameInfos.size();
-  gifFile->SavedImages =
-      (SavedImage *)calloc(frameInfos.size(), sizeof(SavedImage));
-  for (int idx = 0; idx < frameInfos.size(); ++idx) {
-    const QGifFrameInfoData frameInfo = frameInfos.at(idx);
-    QImage image = frameInfo.image;
-    if (image.format() != QImage::Format_Indexed8) {
-      if (!globalColorTable.isEmpty())
-        image =
-            image.convertToFormat(QImage::Format_Indexed8, globalColorTable);
-      else
-        image = image.convertToFormat(QImage::Format_Indexed8);
-    }
+  return EGifCloseFile(gifFile) == GIF_OK && ok;
+}
 
-    SavedImage *gifImage = gifFile->SavedImages + idx;
+/*
+    Writes the header, the logical screen descriptor and the global color
+    table.
+*/
+bool QGifImagePrivate::writeScreen(GifFileType *gifFile,
+                                   const QSize &size) const {
+  // Every frame carries a graphics control extension.
+  EGifSetGifVersion(gifFile, true);
 
-    gifImage->ImageDesc.Left = frameInfo.offset.x();
-    gifImage->ImageDesc.Top = frameInfo.offset.y();
-    gifImage->ImageDesc.Width = image.width();
-    gifImage->ImageDesc.Height = image.height();
-    gifImage->ImageDesc.Interlace = frameInfo.interlace;
+  ColorMapObject *colorMap = colorTableToColorMapObject(globalColorTable);
+  int bgIndex = 0;
+  if (colorMap) {
+    int idx = globalColorTable.indexOf(bgColor.rgba());
+    bgIndex = idx == -1 ? 0 : idx;
+  }
+  int result = EGifPutScreenDesc(gifFile, size.width(), size.height(), 8,
+                                 bgIndex, colorMap);
+  if (colorMap) GifFreeMapObject(colorMap);
+  return result == GIF_OK;
+}
 
-    if (!image.colorTable().isEmpty() &&
-        (image.colorTable() != globalColorTable))
-      gifImage->ImageDesc.ColorMap =
-          colorTableToColorMapObject(image.colorTable());
+/*
+    Writes the NETSCAPE2.0 loop extension, which precedes the first frame.
+*/
+bool QGifImagePrivate::writeLoopExtension(GifFileType *gifFile) const {
+  uchar data8[12] = "NETSCAPE2.0";
+  uchar data[3];
+  data[0] = 0x01;
+  data[1] = loopCount & 0xFF;
+  data[2] = (loopCount >> 8) & 0xFF;
+  return EGifPutExtensionLeader(gifFile, APPLICATION_EXT_FUNC_CODE) !=
+             GIF_ERROR &&
+         EGifPutExtensionBlock(gifFile, 11, data8) != GIF_ERROR &&
+         EGifPutExtensionBlock(gifFile, 3, data) != GIF_ERROR &&
+         EGifPutExtensionTrailer(gifFile) != GIF_ERROR;
+}
+
+/*
+    Converts one frame to indexed colors and encodes it: the graphics
+    control extension, the image descriptor and the LZW data.
+*/
+bool QGifImagePrivate::writeFrame(GifFileType *gifFile,
+                                  const QGifFrameInfoData &frameInfo) const {
+  QImage image = frameInfo.image;
+  if (image.format() != QImage::Format_Indexed8) {
+    if (!globalColorTable.isEmpty())
+      image = image.convertToFormat(QImage::Format_Indexed8, globalColorTable);
     else
-      gifImage->ImageDesc.ColorMap = 0;
+      image = image.convertToFormat(QImage::Format_Indexed8);
+  }
+  if (image.isNull()) return false;
+
+  GraphicsControlBlock gcbBlock;
+  gcbBlock.DisposalMode = 0;
+  gcbBlock.UserInputFlag = false;
+  gcbBlock.TransparentColor = getFrameTransparentColorIndex(frameInfo);
+
+  if (frameInfo.delayTime != -1)
+    gcbBlock.DelayTime = frameInfo.delayTime / 10;  // convert from milliseconds
+  else
+    gcbBlock.DelayTime = defaultDelayTime / 10;
+
+  GifByteType gcbBytes[4];
+  size_t gcbLength = EGifGCBToExtension(&gcbBlock, gcbBytes);
+  if (EGifPutExtension(gifFile, GRAPHICS_EXT_FUNC_CODE, int(gcbLength),
+                       gcbBytes) == GIF_ERROR)
+    return false;
 
-    GifByteType *data = (GifByteType *)malloc(image.width() * image.height() *
-                                              sizeof(GifByteType));
-    for (int row = 0; row < image.height(); ++row) {
-      memcpy(data + row * image.width(), image.scanLine(row), image.width());
-    }
-    gifImage->RasterBits = data;
+  ColorMapObject *colorMap = 0;
+  if (!image.colorTable().isEmpty() && (image.colorTable() != globalColorTable))
+    colorMap = colorTableToColorMapObject(image.colorTable());
+  int result = EGifPutImageDesc(gifFile, frameInfo.offset.x(),
+                                frameInfo.offset.y(), image.width(),
+                                image.height(), frameInfo.interlace, colorMap);
+  if (colorMap) GifFreeMapObject(colorMap);
+
+  // EGifPutLine() masks the line in place, scanLine() gives a private copy.
+  static const int interlacedOffset[] = {0, 4, 2, 1};
+  static const int interlacedJumps[] = {8, 8, 4, 2};
+  int passes = frameInfo.interlace ? 4 : 1;
+  for (int pass = 0; result == GIF_OK && pass < passes; ++pass) {
+    int offset = frameInfo.interlace ? interlacedOffset[pass] : 0;
+    int jump = frameInfo.interlace ? interlacedJumps[pass] : 1;
+    for (int row = offset; result == GIF_OK && row < image.height();
+         row += jump)
+      result = EGifPutLine(gifFile, image.scanLine(row), image.width());
+  }
 
-    if (idx == 0) {
-      uchar data8[12] = "NETSCAPE2.0";
-      GifAddExtensionBlock(&gifImage->ExtensionBlockCount,
-                           &gifImage->ExtensionBlocks,
-                           APPLICATION_EXT_FUNC_CODE, 11, data8);
-      uchar data[3];
-      data[0] = 0x01;
-      data[1] = loopCount & 0xFF;
-      data[2] = (loopCount >> 8) & 0xFF;
-      GifAddExtensionBlock(&gifImage->ExtensionBlockCount,
-                           &gifImage->ExtensionBlocks, CONTINUE_EXT_FUNC_CODE,
-                           3, data);
+  // The encoder keeps a copy of the local color map until the next frame.
+  if (gifFile->Image.ColorMap) {
+    GifFreeMapObject(gifFile->Image.ColorMap);
+    gifFile->Image.ColorMap = 0;
+  }
+  return result == GIF_OK;
+}
+
+/*
+    Encodes one frame into \a bytes, exactly as writeFrame() would write it
+    to the file. Separate frames can be encoded on separate threads.
+*/
+bool QGifImagePrivate::encodeFrame(const QGifFrameInfoData &frameInfo,
+                                   QByteArray *bytes) const {
+  FrameBuffer buffer;
+  buffer.closing = false;
+  int error;
+  GifFileType *gifFile = EGifOpen(&buffer, writeToFrameBuffer, &error);
+  if (!gifFile) return false;
+
+  // No screen descriptor is written here, but frames without a local color
+  // table need the global one to set up the compressor.
+  gifFile->SColorMap = colorTableToColorMapObject(globalColorTable);
+  bool ok = writeFrame(gifFile, frameInfo);
+  buffer.closing = true;
+  EGifCloseFile(gifFile);
+  *bytes = buffer.bytes;
+  return ok;
+}
+
+/*
+    Encodes \a frames and writes them in order. The loop extension is
+    written before the first frame if \a first is set.
+
+    With more than one thread, groups of frames are converted to indexed
+    colors and compressed in parallel into separate buffers, which are then
+    written to \a device one after another. Only one group of compressed
+    frames is held in memory.
+*/
+bool QGifImagePrivate::writeFrames(GifFileType *gifFile, QIODevice *device,
+                                   const QList<QGifFrameInfoData> &frames,
+                                   bool first) const {
+  int threads = threadCount > 0 ? threadCount : QThread::idealThreadCount();
+  if (threads <= 1 || frames.size() <= 1) {
+    for (int idx = 0; idx < frames.size(); ++idx) {
+      if (first && idx == 0 && !writeLoopExtension(gifFile)) return false;
+      if (!writeFrame(gifFile, frames.at(idx))) return false;
     }
+    return true;
+  }
 
-    GraphicsControlBlock gcbBlock;
-    gcbBlock.DisposalMode = 0;
-    gcbBlock.UserInputFlag = false;
-    gcbBlock.TransparentColor = getFrameTransparentColorIndex(frameInfo);
+  QThreadPool pool;
+  pool.setMaxThreadCount(threads);
+  const int groupSize = threads * 2;
+  QVector<QByteArray> encoded(groupSize);
+  QVector<char> encodedOk(groupSize);
+  QByteArray *encodedData = encoded.data();
+  char *encodedOkData = encodedOk.data();
+  for (int begin = 0; begin < frames.size(); begin += groupSize) {
+    int count = qMin(groupSize, int(frames.size()) - begin);
+    for (int i = 0; i < count; ++i) {
+      const QGifFrameInfoData *frameInfo = &frames.at(begin + i);
+      pool.start([this, frameInfo, encodedData, encodedOkData, i]() {
+        encodedOkData[i] = encodeFrame(*frameInfo, encodedData + i);
+      });
+    }
+    pool.waitForDone();
+
+    // giflib does not buffer output between frames, so the encoded bytes
+    // can go straight to the device.
+    for (int i = 0; i < count; ++i) {
+      if (!encodedOkData[i]) return false;
+      if (first && begin + i == 0 && !writeLoopExtension(gifFile))
+        return false;
+      if (device->write(encodedData[i]) != encodedData[i].size()) return false;
+      encodedData[i].clear();
+    }
+  }
+  return true;
+}
 
-    if (frameInfo.delayTime != -1)
-      gcbBlock.DelayTime =
-          frameInfo.delayTime / 10;  // convert from milliseconds
-    else
-      gcbBlock.DelayTime = defaultDelayTime / 10;
+/*
+    Starts an incremental write to \a device. The screen descriptor is
+    written now if the canvas size is known, otherwise with the first frame.
+*/
+bool QGifImagePrivate::openStream(QIODevice *device, bool ownsDevice) {
+  if (streamFile) return false;
 
-    EGifGCBToSavedExtension(&gcbBlock, gifFile, idx);
+  int error;
+  streamFile = EGifOpen(device, writeToIODevice, &error);
+  if (!streamFile) return false;
+
+  streamDevice = device;
+  streamOwnsDevice = ownsDevice;
+  streamScreenWritten = false;
+  streamFrameCount = 0;
+  if (canvasSize.isValid()) {
+    if (!writeScreen(streamFile, canvasSize)) {
+      closeStream();
+      return false;
+    }
+    streamScreenWritten = true;
   }
+  return true;
+}
 
-  EGifSpew(gifFile);
-  // EGifCloseFile(gifFile);
+/*
+    Encodes one frame of an incremental write and passes it to the device.
+*/
+bool QGifImagePrivate::writeStreamFrame(const QGifFrameInfoData &frameInfo) {
+  if (!streamFile) return false;
+
+  if (!streamScreenWritten) {
+    QSize size(frameInfo.image.width() + frameInfo.offset.x(),
+               frameInfo.image.height() + frameInfo.offset.y());
+    if (!writeScreen(streamFile, size)) return false;
+    streamScreenWritten = true;
+  }
+  if (streamFrameCount == 0 && !writeLoopExtension(streamFile)) return false;
+  if (!writeFrame(streamFile, frameInfo)) return false;
+  streamFrameCount++;
+  return true;
+}
 
+/*
+    Encodes several frames of an incremental write, in parallel when more
+    than one thread is available.
+*/
+bool QGifImagePrivate::writeStreamFrames(
+    const QList<QGifFrameInfoData> &frames) {
+  if (!streamFile) return false;
+  if (frames.isEmpty()) return true;
+
+  if (!streamScreenWritten) {
+    const QGifFrameInfoData &frameInfo = frames.first();
+    QSize size(frameInfo.image.width() + frameInfo.offset.x(),
+               frameInfo.image.height() + frameInfo.offset.y());
+    if (!writeScreen(streamFile, size)) return false;
+    streamScreenWritten = true;
+  }
+  if (!writeFrames(streamFile, streamDevice, frames, streamFrameCount == 0))
+    return false;
+  streamFrameCount += frames.size();
   return true;
 }
 
+/*
+    Writes the trailer and finishes an incremental write.
+*/
+bool QGifImagePrivate::closeStream() {
+  if (!streamFile) return false;
+
+  bool ok = true;
+  if (!streamScreenWritten)
+    ok = writeScreen(streamFile,
+                     canvasSize.isValid() ? canvasSize : QSize(0, 0));
+  ok = EGifCloseFile(streamFile) == GIF_OK && ok;
+  streamFile = 0;
+
+  if (streamOwnsDevice) {
+    QFileDevice *file = qobject_cast<QFileDevice *>(streamDevice);
+    if (file) ok = file->flush() && ok;
+    delete streamDevice;
+  }
+  streamDevice = 0;
+  streamOwnsDevice = false;
+  return ok;
+}
+
 /*!
     \class QGifImage
     \inmodule QtGifImage
@@ -616,6 +826,131 @@ bool QGifImage::save(QIODevice *device) const {
   return false;
 }
 
+/*!
+    Starts writing the gif image to \a device frame by frame.
+
+    Frames passed to writeFrame() are encoded and written right away instead
+    of being kept in memory, so the memory used does not grow with the
+    number of frames. The global color table, loop count, default delay and
+    default transparent color must be set before calling this function.
+    Frames written this way are not added to the frame list.
+
+    Returns \c false if a write is already in progress or the device is not
+    writable.
+
+    \sa writeFrame(), close()
+*/
+bool QGifImage::open(QIODevice *device) {
+  Q_D(QGifImage);
+  if (!device || !device->isWritable()) return false;
+  return d->openStream(device, false);
+}
+
+/*!
+    \overload
+
+    Starts writing the gif image to the file with the given \a fileName.
+*/
+bool QGifImage::open(const QString &fileName) {
+  Q_D(QGifImage);
+  if (d->streamFile) return false;
+  QFile *file = new QFile(fileName);
+  if (!file->open(QIODevice::WriteOnly)) {
+    delete file;
+    return false;
+  }
+  return d->openStream(file, true);
+}
+
+/*!
+    Encodes \a frame with \a delay and writes it to the device given to
+    open(). Returns \c true on success.
+*/
+bool QGifImage::writeFrame(const QImage &frame, int delay) {
+  return writeFrame(frame, frame.offset(), delay);
+}
+
+/*!
+    \overload
+
+    Encodes \a frame at the given \a offset with \a delay.
+*/
+bool QGifImage::writeFrame(const QImage &frame, const QPoint &offset,
+                           int delay) {
+  Q_D(QGifImage);
+  QGifFrameInfoData data;
+  data.image = frame;
+  data.delayTime = delay;
+  data.offset = offset;
+
+  return d->writeStreamFrame(data);
+}
+
+/*!
+    Encodes \a frames with \a delay and writes them in order to the device
+    given to open(). The frames are converted and compressed in parallel,
+    see setThreadCount(). Returns \c true on success.
+*/
+bool QGifImage::writeFrames(const QList<QImage> &frames, int delay) {
+  Q_D(QGifImage);
+  QList<QGifFrameInfoData> infos;
+  infos.reserve(frames.size());
+  foreach (const QImage &frame, frames) {
+    QGifFrameInfoData data;
+    data.image = frame;
+    data.delayTime = delay;
+    data.offset = frame.offset();
+    infos.append(data);
+  }
+
+  return d->writeStreamFrames(infos);
+}
+
+/*!
+    Return the number of threads that encode frames in save() and
+    writeFrames(). The default value 0 means one per CPU core.
+*/
+int QGifImage::threadCount() const {
+  Q_D(const QGifImage);
+  return d->threadCount;
+}
+
+/*!
+    Set the number of threads that encode frames to \a count. Every thread
+    converts whole frames to indexed colors and compresses them; the output
+    does not depend on the number of threads. 1 encodes the frames one by
+    one, 0 uses one thread per CPU core.
+*/
+void QGifImage::setThreadCount(int count) {
+  Q_D(QGifImage);
+  d->threadCount = count;
+}
+
+/*!
+    Writes the end of the gif image started with open(). A file opened by
+    open() is closed. Returns \c true if the whole image was written.
+*/
+bool QGifImage::close() {
+  Q_D(QGifImage);
+  return d->closeStream();
+}
+
+/*!
+    Returns \c true between open() and close().
+*/
+bool QGifImage::isOpen() const {
+  Q_D(const QGifImage);
+  return d->streamFile != 0;
+}
+
+/*!
+    Returns the number of frames written since open().
+*/
+int QGifImage::writtenFrameCount() const {
+  Q_D(const QGifImage);
+  return d->streamFrameCount;
+}
+
 /*!
     Loads an gif image from the file with the given \a fileName. Returns \c true
    if the image was successfully loaded; otherwise invalidates the image and
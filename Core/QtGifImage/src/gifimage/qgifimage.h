@@ -52,6 +52,9 @@ public:
     int loopCount() const;
     void setLoopCount(int loop);
 
+    int threadCount() const;
+    void setThreadCount(int count);
+
     int frameCount() const;
     QImage frame(int index) const;
 
@@ -72,6 +75,15 @@ public:
     bool save(QIODevice *device) const;
     bool save(const QString &fileName) const;
 
+    bool open(QIODevice *device);
+    bool open(const QString &fileName);
+    bool writeFrame(const QImage &frame, int delay=-1);
+    bool writeFrame(const QImage &frame, const QPoint &offset, int delay=-1);
+    bool writeFrames(const QList<QImage> &frames, int delay=-1);
+    bool close();
+    bool isOpen() const;
+    int writtenFrameCount() const;
+
 private:
     QGifImagePrivate * const d_ptr;
 };
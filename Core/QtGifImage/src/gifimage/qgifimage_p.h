@@ -54,6 +54,19 @@ public:
     ~QGifImagePrivate();
     bool load(QIODevice *device);
     bool save(QIODevice *device) const;
+    bool writeScreen(GifFileType *gifFile, const QSize &size) const;
+    bool writeLoopExtension(GifFileType *gifFile) const;
+    bool writeFrame(GifFileType *gifFile,
+                    const QGifFrameInfoData &frameInfo) const;
+    bool encodeFrame(const QGifFrameInfoData &frameInfo,
+                     QByteArray *bytes) const;
+    bool writeFrames(GifFileType *gifFile, QIODevice *device,
+                     const QList<QGifFrameInfoData> &frames,
+                     bool first) const;
+    bool openStream(QIODevice *device, bool ownsDevice);
+    bool writeStreamFrame(const QGifFrameInfoData &frameInfo);
+    bool writeStreamFrames(const QList<QGifFrameInfoData> &frames);
+    bool closeStream();
     QVector<QRgb> colorTableFromColorMapObject(ColorMapObject *object, int transColorIndex=-1) const;
     ColorMapObject * colorTableToColorMapObject(QVector<QRgb> colorTable) const;
     QSize getCanvasSize() const;
@@ -62,12 +75,20 @@ public:
     QSize canvasSize;
     int loopCount;
     int defaultDelayTime;
+    int threadCount;
     QColor defaultTransparentColor;
 
     QVector<QRgb> globalColorTable;
     QColor bgColor;
     QList<QGifFrameInfoData> frameInfos;
 
+    // Incremental writer used by open(), writeFrame() and close()
+    GifFileType *streamFile;
+    QIODevice *streamDevice;
+    bool streamOwnsDevice;
+    bool streamScreenWritten;
+    int streamFrameCount;
+
     QGifImage *q_ptr;
 };
 
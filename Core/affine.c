@@ -21,10 +21,159 @@
  * - rotate_x(), rotate_y(), rotate_z(): Specialized functions for rotating
  * around X, Y, Z axes
  * - scale(): Uniformly scales the object
+ *
+ * The viewer itself does not change the vertices. It keeps the parsed
+ * coordinates and composes every change into a 4x4 model matrix with
+ * model_move(), model_rotate_x/y/z() and model_scale(), which takes constant
+ * time regardless of the size of the model. Model matrices are stored in
+ * column-major order, as expected by glLoadMatrixd().
+ *
+ * The sine and cosine of a rotation are computed once per call. Large models
+ * are transformed by several threads, see affine_set_parallel(). For bulk
+ * work the vectorized soa_*() kernels of simd.c are faster per thread.
  */
 
 #include "3DViever.h"
 
+/// Smallest model transformed by several threads, in vertices
+#define AFFINE_PARALLEL_MIN ((size_t)1 << 18)
+/// Number of vertices transformed by one task of a parallel transformation
+#define AFFINE_CHUNK ((size_t)1 << 16)
+
+/// Threads used for large models, 0 for one per CPU core
+static int affine_threads = 0;
+/// Models with fewer vertices are transformed by the calling thread
+static size_t affine_parallel_min = AFFINE_PARALLEL_MIN;
+
+/**
+ * @struct affine_job
+ * @brief Transformation of the vertex rows of one object
+ *
+ * kernel() transforms count rows starting at vertices, reading its
+ * parameters from args. A parallel run gives every task AFFINE_CHUNK rows.
+ */
+typedef struct affine_job {
+  vertex_t *vertices;
+  size_t count;
+  void (*kernel)(vertex_t *vertices, size_t count, const double *args);
+  double args[4];
+} affine_job;
+
+/**
+ * @brief Adds args[1] to coordinate args[0] of every row
+ */
+static void move_kernel(vertex_t *vertices, size_t count, const double *args) {
+  size_t axis = (size_t)args[0];
+  double delta = args[1];
+  for (size_t i = 0; i < count; i++) vertices[i * 3 + axis] += delta;
+}
+
+/**
+ * @brief Rotates coordinates args[0] and args[1] of every row
+ *
+ * a = a * cos + b * sin; b = -a * sin + b * cos, with the cosine in args[2]
+ * and the sine in args[3].
+ */
+static void rotate_kernel(vertex_t *vertices, size_t count,
+                          const double *args) {
+  size_t a = (size_t)args[0], b = (size_t)args[1];
+  double c = args[2], s = args[3];
+  for (size_t i = 0; i < count; i++) {
+    vertex_t *row = vertices + i * 3;
+    double u = row[a], v = row[b];
+    row[a] = u * c + v * s;
+    row[b] = -u * s + v * c;
+  }
+}
+
+/**
+ * @brief Multiplies every coordinate by args[0]
+ */
+static void scale_kernel(vertex_t *vertices, size_t count, const double *args) {
+  double factor = args[0];
+  for (size_t i = 0; i < count * 3; i++) vertices[i] *= factor;
+}
+
+/**
+ * @brief Runs one chunk of a parallel transformation
+ *
+ * @param context Pointer to the affine_job
+ * @param index Number of the chunk
+ */
+static void affine_task(void *context, size_t index) {
+  affine_job *job = context;
+  size_t begin = index * AFFINE_CHUNK;
+  size_t count = job->count - begin < AFFINE_CHUNK ? job->count - begin
+                                                   : AFFINE_CHUNK;
+  job->kernel(job->vertices + begin * 3, count, job->args);
+}
+
+/**
+ * @brief Applies a kernel to every vertex of an object
+ *
+ * Models with at least affine_parallel_min vertices are split into chunks
+ * that are transformed by a thread pool. Every vertex is transformed on its
+ * own, so the result does not depend on the number of threads.
+ *
+ * @param data_obj Pointer to the 3D object structure
+ * @param job Kernel and its parameters
+ */
+static void affine_run(data_object *data_obj, affine_job *job) {
+  if (data_obj->vertex_array.matrix && data_obj->vertex_count > 0) {
+    job->vertices = data_obj->vertex_array.matrix + 3;
+    job->count = data_obj->vertex_count;
+    if (job->count >= affine_parallel_min && affine_threads != 1)
+      parallel_for((job->count + AFFINE_CHUNK - 1) / AFFINE_CHUNK,
+                   affine_threads, affine_task, job);
+    else
+      job->kernel(job->vertices, job->count, job->args);
+  }
+}
+
+/**
+ * @brief Moves a 3D object along one axis
+ *
+ * @param data_obj Pointer to the 3D object structure
+ * @param axis 0 for X, 1 for Y, 2 for Z
+ * @param delta Distance to move
+ */
+static void move(data_object *data_obj, int axis, double delta) {
+  affine_job job = {.kernel = move_kernel, .args = {axis, delta}};
+  affine_run(data_obj, &job);
+}
+
+/**
+ * @brief Rotates a 3D object in the plane of two axes
+ *
+ * @param data_obj Pointer to the 3D object structure
+ * @param a First axis of the plane
+ * @param b Second axis of the plane
+ * @param angle Rotation angle in degrees, positive from b towards a
+ */
+static void rotate(data_object *data_obj, int a, int b, double angle) {
+  double radians = angle * M_PI / 180.0;
+  affine_job job = {.kernel = rotate_kernel,
+                    .args = {a, b, cos(radians), sin(radians)}};
+  affine_run(data_obj, &job);
+}
+
+/**
+ * @brief Sets how the vertex functions of this module use threads
+ *
+ * Models with at least min_vertices vertices are transformed by threads
+ * threads; smaller ones by the calling thread only. The defaults are one
+ * thread per CPU core from 262144 vertices on. Call it before starting any
+ * transformation.
+ *
+ * @param threads Number of threads, 0 for one per CPU core, 1 to disable
+ * @param min_vertices Smallest model transformed in parallel, 0 for the
+ * default
+ */
+void affine_set_parallel(int threads, size_t min_vertices) {
+  affine_threads = threads > 0 ? threads : 0;
+  affine_parallel_min = min_vertices ? min_vertices : AFFINE_PARALLEL_MIN;
+}
+
 /**
  * @brief Moves a 3D object along the X-axis
  *
@@ -33,11 +182,7 @@
  * @param old_value Old position along the X-axis
  */
 void move_x(data_object *data_obj, double new_value, double old_value) {
-  if (data_obj->vertex_array.matrix) {
-    for (size_t i = 3; i < (data_obj->vertex_count + 1) * 3; i += 3) {
-      data_obj->vertex_array.matrix[i] += (new_value - old_value);
-    }
-  }
+  move(data_obj, 0, new_value - old_value);
 }
 
 /**
@@ -48,11 +193,7 @@ void move_x(data_object *data_obj, double new_value, double old_value) {
  * @param old_value Old position along the Y-axis
  */
 void move_y(data_object *data_obj, double new_value, double old_value) {
-  if (data_obj->vertex_array.matrix) {
-    for (size_t i = 4; i < (data_obj->vertex_count + 1) * 3; i += 3) {
-      data_obj->vertex_array.matrix[i] += (new_value - old_value);
-    }
-  }
+  move(data_obj, 1, new_value - old_value);
 }
 
 /**
@@ -63,74 +204,46 @@ void move_y(data_object *data_obj, double new_value, double old_value) {
  * @param old_value Old position along the Z-axis
  */
 void move_z(data_object *data_obj, double new_value, double old_value) {
-  if (data_obj->vertex_array.matrix) {
-    for (size_t i = 5; i < (data_obj->vertex_count + 1) * 3; i += 3) {
-      data_obj->vertex_array.matrix[i] += (new_value - old_value);
-    }
-  }
+  move(data_obj, 2, new_value - old_value);
 }
 
 /**
  * @brief Rotates a 3D object around the X-axis
  *
+ * y = y * cos + z * sin; z = -y * sin + z * cos
+ *
  * @param data_obj Pointer to the 3D object structure
  * @param new_angle New rotation angle in degrees
  * @param old_angle Old rotation angle in degrees
  */
 void rotate_x(data_object *data_obj, double new_angle, double old_angle) {
-  new_angle = new_angle * M_PI / 180.0;
-  old_angle = old_angle * M_PI / 180.0;
-  for (size_t i = 0; i < (data_obj->vertex_count + 1) * 3; i += 3) {
-    double y = data_obj->vertex_array.matrix[i + 1];
-    double z = data_obj->vertex_array.matrix[i + 2];
-    // x = x; y = y * cos + z * sin; z = -y * sin + z * cos;
-    data_obj->vertex_array.matrix[i + 1] =
-        y * cosf(new_angle - old_angle) + z * sinf(new_angle - old_angle);
-    data_obj->vertex_array.matrix[i + 2] =
-        -y * sinf(new_angle - old_angle) + z * cosf(new_angle - old_angle);
-  }
+  rotate(data_obj, 1, 2, new_angle - old_angle);
 }
 
 /**
  * @brief Rotates a 3D object around the Y-axis
  *
+ * x = x * cos + z * sin; z = -x * sin + z * cos
+ *
  * @param data_obj Pointer to the 3D object structure
  * @param new_angle New rotation angle in degrees
  * @param old_angle Old rotation angle in degrees
  */
 void rotate_y(data_object *data_obj, double new_angle, double old_angle) {
-  new_angle = new_angle * M_PI / 180.0;
-  old_angle = old_angle * M_PI / 180.0;
-  for (size_t i = 0; i < (data_obj->vertex_count + 1) * 3; i += 3) {
-    double x = data_obj->vertex_array.matrix[i];
-    double z = data_obj->vertex_array.matrix[i + 2];
-    // x = x * cos + z * sin; y = y; z = -x * sin + z * cos;
-    data_obj->vertex_array.matrix[i] =
-        x * cosf(new_angle - old_angle) + z * sinf(new_angle - old_angle);
-    data_obj->vertex_array.matrix[i + 2] =
-        -x * sinf(new_angle - old_angle) + z * cosf(new_angle - old_angle);
-  }
+  rotate(data_obj, 0, 2, new_angle - old_angle);
 }
 
 /**
  * @brief Rotates a 3D object around the Z-axis
  *
+ * x = x * cos - y * sin; y = x * sin + y * cos
+ *
  * @param data_obj Pointer to the 3D object structure
  * @param new_angle New rotation angle in degrees
  * @param old_angle Old rotation angle in degrees
  */
 void rotate_z(data_object *data_obj, double new_angle, double old_angle) {
-  new_angle = new_angle * M_PI / 180.0;
-  old_angle = old_angle * M_PI / 180.0;
-  for (size_t i = 0; i < (data_obj->vertex_count + 1) * 3; i += 3) {
-    double x = data_obj->vertex_array.matrix[i];
-    double y = data_obj->vertex_array.matrix[i + 1];
-    // x = x * cos - y * sin; y = x * sin + y * cos; z = z;
-    data_obj->vertex_array.matrix[i] =
-        x * cosf(new_angle - old_angle) - y * sinf(new_angle - old_angle);
-    data_obj->vertex_array.matrix[i + 1] =
-        x * sinf(new_angle - old_angle) + y * cosf(new_angle - old_angle);
-  }
+  rotate(data_obj, 0, 1, -(new_angle - old_angle));
 }
 
 /**
@@ -141,7 +254,139 @@ void rotate_z(data_object *data_obj, double new_angle, double old_angle) {
  * @param old_scale Old scale factor
  */
 void scale(data_object *data_obj, int new_scale, int old_scale) {
-  for (size_t i = 3; i < (data_obj->vertex_count + 1) * 3; i++) {
-    data_obj->vertex_array.matrix[i] *= (double)new_scale / (double)old_scale;
-  }
+  affine_job job = {.kernel = scale_kernel,
+                    .args = {(double)new_scale / (double)old_scale}};
+  affine_run(data_obj, &job);
+}
+
+/**
+ * @brief Applies a transformation after the ones already in a model matrix
+ *
+ * Computes matrix = step * matrix, so the step acts on the model as it is
+ * currently shown, the same way the vertex functions of this module do.
+ *
+ * @param matrix Model matrix
+ * @param step Transformation to apply
+ */
+static void model_apply(double *matrix, const double *step) {
+  double result[16];
+  for (int col = 0; col < 4; col++)
+    for (int row = 0; row < 4; row++) {
+      double sum = 0;
+      for (int k = 0; k < 4; k++)
+        sum += step[k * 4 + row] * matrix[col * 4 + k];
+      result[col * 4 + row] = sum;
+    }
+  memcpy(matrix, result, sizeof(result));
+}
+
+/**
+ * @brief Builds a rotation by the given angle around one axis
+ *
+ * Uses the same direction of rotation as rotate_x(), rotate_y() and
+ * rotate_z().
+ *
+ * @param matrix Model matrix
+ * @param angle Rotation angle in degrees
+ * @param a First coordinate changed by the rotation
+ * @param b Second coordinate changed by the rotation
+ * @param sign Sign of the sine in the new value of a
+ */
+static void model_rotate(double *matrix, double angle, int a, int b,
+                         double sign) {
+  double step[16];
+  model_identity(step);
+  double radians = angle * M_PI / 180.0;
+  double c = cos(radians), s = sin(radians) * sign;
+  step[a * 4 + a] = c;
+  step[b * 4 + a] = s;
+  step[a * 4 + b] = -s;
+  step[b * 4 + b] = c;
+  model_apply(matrix, step);
+}
+
+/**
+ * @brief Sets a model matrix to the identity
+ *
+ * @param matrix Model matrix of 16 values
+ */
+void model_identity(double *matrix) {
+  memset(matrix, 0, 16 * sizeof(double));
+  for (int i = 0; i < 4; i++) matrix[i * 5] = 1;
+}
+
+/**
+ * @brief Moves the model by the given offsets
+ *
+ * @param matrix Model matrix
+ * @param dx Offset along the X-axis
+ * @param dy Offset along the Y-axis
+ * @param dz Offset along the Z-axis
+ */
+void model_move(double *matrix, double dx, double dy, double dz) {
+  double step[16];
+  model_identity(step);
+  step[12] = dx;
+  step[13] = dy;
+  step[14] = dz;
+  model_apply(matrix, step);
+}
+
+/**
+ * @brief Rotates the model around the X-axis
+ *
+ * @param matrix Model matrix
+ * @param angle Rotation angle in degrees
+ */
+void model_rotate_x(double *matrix, double angle) {
+  model_rotate(matrix, angle, 1, 2, 1);
+}
+
+/**
+ * @brief Rotates the model around the Y-axis
+ *
+ * @param matrix Model matrix
+ * @param angle Rotation angle in degrees
+ */
+void model_rotate_y(double *matrix, double angle) {
+  model_rotate(matrix, angle, 0, 2, 1);
+}
+
+/**
+ * @brief Rotates the model around the Z-axis
+ *
+ * @param matrix Model matrix
+ * @param angle Rotation angle in degrees
+ */
+void model_rotate_z(double *matrix, double angle) {
+  model_rotate(matrix, angle, 0, 1, -1);
+}
+
+/**
+ * @brief Scales the model uniformly
+ *
+ * @param matrix Model matrix
+ * @param factor Scale factor
+ */
+void model_scale(double *matrix, double factor) {
+  double step[16];
+  model_identity(step);
+  for (int i = 0; i < 3; i++) step[i * 5] = factor;
+  model_apply(matrix, step);
+}
+
+/**
+ * @brief Transforms a point with a model matrix
+ *
+ * @param matrix Model matrix
+ * @param point Coordinates x, y and z
+ * @param result Transformed coordinates, may be the same array as point
+ */
+void model_transform(const double *matrix, const double *point,
+                     double *result) {
+  double out[3];
+  for (int row = 0; row < 3; row++)
+    out[row] = matrix[row] * point[0] + matrix[4 + row] * point[1] +
+               matrix[8 + row] * point[2] + matrix[12 + row];
+  memcpy(result, out, sizeof(out));
 }
@@ -0,0 +1,137 @@
+/**
+ * @file arena.c
+ * @brief Growable arena that owns the memory of a loaded model
+ *
+ * Every buffer of a data_object is carved out of the arena of that object.
+ * The model is freed by resetting the arena, which takes constant time no
+ * matter how many buffers were handed out, and the pages of the arena are
+ * reused by the next model loaded into the same object.
+ *
+ * Key features:
+ * - Bump allocation from large blocks, 64-byte aligned
+ * - New blocks are added when the free space runs out
+ * - Reset keeps the largest block so that reloads do not touch the allocator
+ * - Counters for reserved bytes, used bytes and the high-water mark
+ */
+
+#include "3DViever.h"
+
+#include <stdint.h>
+
+/// Alignment of every allocation, enough for any vector register
+#define ARENA_ALIGN ((size_t)64)
+/// Smallest block requested from the system
+#define ARENA_BLOCK_MIN ((size_t)1 << 20)
+/// Size of the block header, rounded up to keep the data aligned
+#define ARENA_HEADER \
+  ((sizeof(arena_block) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+/**
+ * @brief Returns the first usable byte of a block
+ *
+ * @param block Arena block
+ * @return Start of the data area
+ */
+static char *block_data(arena_block *block) {
+  return (char *)block + ARENA_HEADER;
+}
+
+/**
+ * @brief Adds a block that can hold at least size bytes
+ *
+ * @param arena Arena
+ * @param size Required free space in bytes, a multiple of ARENA_ALIGN
+ * @return New block, NULL if the memory could not be allocated
+ */
+static arena_block *arena_grow(arena_t *arena, size_t size) {
+  size_t block_size = size > ARENA_BLOCK_MIN ? size : ARENA_BLOCK_MIN;
+  arena_block *block = aligned_alloc(ARENA_ALIGN, ARENA_HEADER + block_size);
+  if (block) {
+    block->next = NULL;
+    block->size = block_size;
+    block->used = 0;
+    arena_block **tail = &arena->blocks;
+    while (*tail) tail = &(*tail)->next;
+    *tail = block;
+    arena->reserved += block_size;
+  }
+  return block;
+}
+
+/**
+ * @brief Allocates memory from an arena
+ *
+ * The memory is not initialized and stays valid until the arena is reset or
+ * released.
+ *
+ * @param arena Arena
+ * @param size Size in bytes
+ * @return Pointer aligned to 64 bytes, NULL if the memory could not be
+ * allocated
+ */
+void *arena_alloc(arena_t *arena, size_t size) {
+  void *memory = NULL;
+  if (arena && size <= SIZE_MAX - ARENA_HEADER - ARENA_ALIGN) {
+    size = size ? (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1) : ARENA_ALIGN;
+    arena_block *block = arena->blocks;
+    while (block && block->size - block->used < size) block = block->next;
+    if (!block) block = arena_grow(arena, size);
+    if (block) {
+      memory = block_data(block) + block->used;
+      block->used += size;
+      arena->used += size;
+      if (arena->used > arena->high_water) arena->high_water = arena->used;
+    }
+  }
+  return memory;
+}
+
+/**
+ * @brief Invalidates every allocation of an arena but keeps its memory
+ *
+ * Only the largest block is kept, so a model of the same size as the previous
+ * one fits in a single block that is already mapped.
+ *
+ * @param arena Arena
+ */
+void arena_reset(arena_t *arena) {
+  if (arena) {
+    arena_block *largest = arena->blocks;
+    for (arena_block *block = arena->blocks; block; block = block->next)
+      if (block->size > largest->size) largest = block;
+    arena_block *block = arena->blocks;
+    while (block) {
+      arena_block *next = block->next;
+      if (block != largest) {
+        arena->reserved -= block->size;
+        free(block);
+      }
+      block = next;
+    }
+    if (largest) {
+      largest->next = NULL;
+      largest->used = 0;
+    }
+    arena->blocks = largest;
+    arena->used = 0;
+  }
+}
+
+/**
+ * @brief Returns all memory of an arena to the system
+ *
+ * The counters, including the high-water mark, start again from zero.
+ *
+ * @param arena Arena
+ */
+void arena_release(arena_t *arena) {
+  if (arena) {
+    arena_block *block = arena->blocks;
+    while (block) {
+      arena_block *next = block->next;
+      free(block);
+      block = next;
+    }
+    memset(arena, 0, sizeof(arena_t));
+  }
+}
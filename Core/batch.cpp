@@ -0,0 +1,409 @@
+/**
+ * @file batch.cpp
+ * @brief Command-line batch renderer of thumbnails and turntable GIFs
+ *
+ * Renders every given .obj file with the software rasterizer, without
+ * creating any window, and saves a PNG thumbnail or an animated GIF of the
+ * model turning around the Y axis. Directories are expanded to the .obj files
+ * they contain. Files are spread over a worker pool, one file per task.
+ * Inputs with the same base name get numbered outputs, so no two workers
+ * write the same file.
+ *
+ * Drawing settings are read from the same settings.ini keys as the viewer, so
+ * the thumbnails look like the models on screen.
+ */
+
+#include <QColor>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QSet>
+#include <QSettings>
+#include <QTextStream>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "QtGifImage/src/gifimage/qgifimage.h"
+
+extern "C" {
+#include "3DViever.h"
+}
+
+/**
+ * @struct batch_options
+ * @brief What to render and how, shared by all workers
+ *
+ * render holds the drawing settings from settings.ini; its model_matrix,
+ * extent and threads are filled in per file. frames is 0 for a PNG and the
+ * number of GIF frames otherwise.
+ */
+struct batch_options {
+  render_settings render = {};
+  bool quantize = false;
+  int frames = 0;
+  int delay = 100;
+  int jobs = 0;
+  int inner_threads = 1;
+  QString output;
+};
+
+/**
+ * @struct stage_times
+ * @brief Duration of the stages of one file in milliseconds
+ *
+ * render and encode cover all frames of a GIF.
+ */
+struct stage_times {
+  double load = 0;
+  double quantize = 0;
+  double edges = 0;
+  double render = 0;
+  double encode = 0;
+
+  void add(const stage_times &other) {
+    load += other.load;
+    quantize += other.quantize;
+    edges += other.edges;
+    render += other.render;
+    encode += other.encode;
+  }
+};
+
+/**
+ * @struct file_result
+ * @brief Outcome of one file
+ */
+struct file_result {
+  bool ok = false;
+  QString output;
+  QString error;
+  stage_times times;
+};
+
+/**
+ * @struct batch_job
+ * @brief Context of the parallel_for() over the files
+ */
+struct batch_job {
+  const batch_options *options;
+  const QStringList *files;
+  const QStringList *outputs;
+  std::vector<file_result> *results;
+};
+
+/**
+ * @brief Copies a QColor into an RGB triple in [0, 1]
+ */
+static void set_color(double *rgb, const QColor &color) {
+  rgb[0] = color.redF();
+  rgb[1] = color.greenF();
+  rgb[2] = color.blueF();
+}
+
+/**
+ * @brief Reads the drawing settings written by the viewer
+ *
+ * Uses the keys of MainWindow::load_settings(). Missing keys keep the
+ * defaults of a fresh viewer window.
+ *
+ * @param file_name Path of settings.ini
+ * @param options Options to fill
+ */
+static void read_settings(const QString &file_name, batch_options *options) {
+  QSettings settings(file_name, QSettings::IniFormat);
+  render_settings &render = options->render;
+  render.projection = settings.value("projection", 1).toInt();
+  render.type_line = settings.value("type_line", 1).toInt();
+  render.thickness = settings.value("thickness", 1).toDouble();
+  render.size_points = settings.value("size_points", 1).toDouble();
+  render.type_point = settings.value("type_point", 0).toInt();
+  set_color(render.line_color,
+            QColor(settings.value("line_color", "#ffff00").toString()));
+  set_color(render.points_color,
+            QColor(settings.value("points_color", "#0000ff").toString()));
+  set_color(render.background_color,
+            QColor(settings.value("background_color", "#000000").toString()));
+  options->quantize = settings.value("quantize", false).toBool();
+}
+
+/**
+ * @brief Expands the command-line inputs into a list of .obj files
+ *
+ * A directory stands for the .obj files directly inside it, sorted by name.
+ * Lines of a list file are treated the same way as arguments; "-" reads the
+ * list from stdin.
+ *
+ * @param inputs Files and directories
+ * @param list_name List file, empty if not given
+ * @param files Files to render
+ * @return false if the list file cannot be read
+ */
+static bool collect_files(QStringList inputs, const QString &list_name,
+                          QStringList *files) {
+  if (!list_name.isEmpty()) {
+    QFile list(list_name);
+    bool opened = list_name == "-"
+                      ? list.open(stdin, QIODevice::ReadOnly | QIODevice::Text)
+                      : list.open(QIODevice::ReadOnly | QIODevice::Text);
+    if (!opened) return false;
+    QTextStream stream(&list);
+    while (!stream.atEnd()) {
+      QString line = stream.readLine().trimmed();
+      if (!line.isEmpty()) inputs << line;
+    }
+  }
+  for (const QString &input : inputs) {
+    QFileInfo info(input);
+    if (info.isDir()) {
+      const QFileInfoList entries = QDir(input).entryInfoList(
+          {"*.obj"}, QDir::Files | QDir::Readable, QDir::Name);
+      for (const QFileInfo &entry : entries) *files << entry.filePath();
+    } else {
+      *files << input;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Chooses the output file of every input
+ *
+ * The output is named after the input with the .png or .gif suffix. Repeated
+ * names, compared without case for case-insensitive file systems, get "_2",
+ * "_3" and so on appended in input order.
+ *
+ * @param options Batch options
+ * @param files Files to render
+ * @return Output files, one per input
+ */
+static QStringList output_names(const batch_options &options,
+                                const QStringList &files) {
+  QString suffix = options.frames > 0 ? ".gif" : ".png";
+  QStringList outputs;
+  QSet<QString> used;
+  for (const QString &file_name : files) {
+    QString base = QFileInfo(file_name).completeBaseName();
+    QString name = base + suffix;
+    for (int index = 2; used.contains(name.toLower()); index++)
+      name = base + "_" + QString::number(index) + suffix;
+    used.insert(name.toLower());
+    outputs << QDir(options.output).filePath(name);
+  }
+  return outputs;
+}
+
+/**
+ * @brief Loads, renders and saves one file, called on a worker thread
+ *
+ * @param options Batch options
+ * @param file_name Model to render
+ * @param output File the image or animation is saved to
+ * @return Outcome and stage timings
+ */
+static file_result render_file(const batch_options &options,
+                               const QString &file_name,
+                               const QString &output) {
+  file_result result;
+  result.output = output;
+  stage_times &times = result.times;
+  QElapsedTimer timer;
+  timer.start();
+  double start = 0;
+  auto lap = [&timer, &start]() {
+    double now = timer.nsecsElapsed() / 1e6, elapsed = now - start;
+    start = now;
+    return elapsed;
+  };
+  data_object data_obj = {};
+  parser_options parser = {};
+  parser.threads = options.inner_threads;
+  QByteArray name = file_name.toUtf8();
+  int status = load_obj(name.data(), &data_obj, &parser, nullptr);
+  times.load = lap();
+  if (status == OK && options.quantize) {
+    status = quantize_object(&data_obj);
+    times.quantize = lap();
+  }
+  if (status == OK) {
+    status = build_edges(&data_obj);
+    times.edges = lap();
+  }
+  if (status != OK) {
+    memory_free(&data_obj);
+    result.error = "cannot load the model";
+    return result;
+  }
+
+  double matrix[16];
+  render_settings render = options.render;
+  render.model_matrix = matrix;
+  render.extent = model_extent(&data_obj);
+  render.threads = options.inner_threads;
+  QSize size(render.width, render.height);
+  QGifImage gif(size);
+  gif.setThreadCount(options.inner_threads);
+  if (options.frames > 0 && !gif.open(result.output)) status = ERROR;
+  // Группа кадров GIF сжимается параллельно, в памяти только она
+  QList<QImage> group;
+  int group_size = options.inner_threads > 1 ? options.inner_threads * 2 : 1;
+  int frames = std::max(options.frames, 1);
+  for (int frame = 0; frame < frames && status == OK; frame++) {
+    // Исходное положение модели такое же, как в только что открытом окне
+    model_identity(matrix);
+    model_rotate_y(matrix, 360.0 * frame / frames);
+    QImage image(size, QImage::Format_RGBA8888);
+    if (image.isNull() || soft_render(&data_obj, &render, image.bits()) != OK)
+      status = ERROR;
+    times.render += lap();
+    if (status != OK) break;
+    if (options.frames > 0) {
+      group.append(image);
+      if (group.size() == group_size || frame == frames - 1) {
+        if (!gif.writeFrames(group, options.delay)) status = ERROR;
+        group.clear();
+      }
+    } else if (!image.save(result.output, "PNG"))
+      status = ERROR;
+    times.encode += lap();
+  }
+  if (gif.isOpen()) {
+    if (!gif.close()) status = ERROR;
+    times.encode += lap();
+  }
+  memory_free(&data_obj);
+  result.ok = status == OK;
+  if (!result.ok) result.error = "cannot render or save " + result.output;
+  return result;
+}
+
+/**
+ * @brief Renders one file of the batch, called by parallel_for()
+ */
+static void render_task(void *context, size_t index) {
+  batch_job *job = static_cast<batch_job *>(context);
+  int file = static_cast<int>(index);
+  (*job->results)[index] =
+      render_file(*job->options, (*job->files)[file], (*job->outputs)[file]);
+}
+
+/**
+ * @brief Prints the per-file results and the summary
+ */
+static void print_report(const QStringList &files,
+                         const std::vector<file_result> &results,
+                         const batch_options &options, double wall_ms) {
+  stage_times total;
+  int done = 0;
+  for (int i = 0; i < files.size(); i++) {
+    const file_result &result = results[i];
+    if (result.ok) {
+      done++;
+      total.add(result.times);
+      std::printf("%s -> %s  %.1f ms\n", qUtf8Printable(files[i]),
+                  qUtf8Printable(result.output),
+                  result.times.load + result.times.quantize +
+                      result.times.edges + result.times.render +
+                      result.times.encode);
+    } else {
+      std::fprintf(stderr, "%s: %s\n", qUtf8Printable(files[i]),
+                   qUtf8Printable(result.error));
+    }
+  }
+  std::printf("\n%d of %lld files in %.1f ms, %.2f files/s, %d workers x %d "
+              "render threads\n",
+              done, static_cast<long long>(files.size()), wall_ms,
+              wall_ms > 0 ? files.size() / (wall_ms / 1e3) : 0.0,
+              std::min<int>(options.jobs, files.size()), options.inner_threads);
+  if (done == 0) return;
+  // Время стадий суммируется по всем потокам, поэтому может превышать общее
+  const struct {
+    const char *name;
+    double ms;
+  } stages[] = {{"load", total.load},     {"quantize", total.quantize},
+                {"edges", total.edges},   {"render", total.render},
+                {"encode", total.encode}};
+  std::printf("%-10s %12s %12s\n", "stage", "total ms", "ms/file");
+  for (const auto &stage : stages)
+    std::printf("%-10s %12.1f %12.2f\n", stage.name, stage.ms,
+                stage.ms / done);
+}
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  QCommandLineParser command_line;
+  command_line.setApplicationDescription(
+      "Renders PNG thumbnails or turntable GIFs of .obj models without the "
+      "viewer window.");
+  command_line.addHelpOption();
+  command_line.addPositionalArgument("inputs", ".obj files or directories",
+                                     "[inputs...]");
+  QCommandLineOption output_option({"o", "output"}, "Output directory.",
+                                   "dir", ".");
+  QCommandLineOption size_option({"s", "size"}, "Image size.", "WxH",
+                                 "640x480");
+  QCommandLineOption gif_option("gif", "Render a turntable GIF of N frames.",
+                                "N");
+  QCommandLineOption delay_option("delay", "GIF frame delay.", "ms", "100");
+  QCommandLineOption jobs_option({"j", "jobs"},
+                                 "Files rendered at once, 0 for one per core.",
+                                 "N", "0");
+  QCommandLineOption list_option({"l", "list"},
+                                 "Read inputs from a file, - for stdin.",
+                                 "file");
+  QCommandLineOption settings_option(
+      "settings", "Viewer settings to use.", "file",
+      QCoreApplication::applicationDirPath() + "/settings.ini");
+  command_line.addOptions({output_option, size_option, gif_option,
+                           delay_option, jobs_option, list_option,
+                           settings_option});
+  command_line.process(app);
+
+  batch_options options;
+  read_settings(command_line.value(settings_option), &options);
+  QStringList size = command_line.value(size_option).split('x');
+  options.render.width = size.value(0).toInt();
+  options.render.height = size.value(1).toInt();
+  options.frames = command_line.value(gif_option).toInt();
+  options.delay = command_line.value(delay_option).toInt();
+  options.jobs = command_line.value(jobs_option).toInt();
+  options.output = command_line.value(output_option);
+  if (size.size() != 2 || options.render.width <= 0 ||
+      options.render.height <= 0 || options.frames < 0 || options.jobs < 0) {
+    std::fprintf(stderr, "invalid size, frame count or number of jobs\n");
+    return 2;
+  }
+  if (options.jobs == 0) options.jobs = parallel_threads();
+
+  QStringList files;
+  if (!collect_files(command_line.positionalArguments(),
+                     command_line.value(list_option), &files)) {
+    std::fprintf(stderr, "cannot read %s\n",
+                 qUtf8Printable(command_line.value(list_option)));
+    return 2;
+  }
+  if (files.isEmpty()) command_line.showHelp(2);
+  if (!QDir().mkpath(options.output)) {
+    std::fprintf(stderr, "cannot create %s\n", qUtf8Printable(options.output));
+    return 2;
+  }
+  // Если файлов меньше, чем потоков, свободные ядра делят парсер и растеризатор
+  options.inner_threads =
+      std::max(1, options.jobs / static_cast<int>(files.size()));
+
+  QStringList outputs = output_names(options, files);
+  std::vector<file_result> results(files.size());
+  batch_job job = {&options, &files, &outputs, &results};
+  QElapsedTimer timer;
+  timer.start();
+  parallel_for(files.size(), options.jobs, render_task, &job);
+  double wall_ms = timer.nsecsElapsed() / 1e6;
+  print_report(files, results, options, wall_ms);
+  for (const file_result &result : results)
+    if (!result.ok) return 1;
+  return 0;
+}
@@ -0,0 +1,388 @@
+/**
+ * @file cache.c
+ * @brief Binary cache of parsed .obj models
+ *
+ * This module stores the parsed vertex buffer, the flattened polygon indices
+ * and the counts of a data_object in a compact binary file. When the same
+ * .obj file is opened again the cache file is mapped into memory and used
+ * as-is, skipping text parsing entirely.
+ *
+ * Key features:
+ * - Cache entries are keyed by the absolute path, size and modification time
+ *   of the .obj file
+ * - Entries live in $XDG_CACHE_HOME/3DViever, ~/.cache/3DViever or, failing
+ *   both, next to the .obj file
+ * - Entries are written to a temporary file and renamed into place, so a
+ *   reader never sees a partial entry
+ * - Mapped entries are validated before use and private to the process, so
+ *   transformations of the model never reach the file
+ *
+ * File layout: a cache_header, the path of the .obj file, padding to 64
+ * bytes, the vertex matrix (including the zero row) padded to 8 bytes, the
+ * polygon offsets as 64-bit integers and the 32-bit vertex indices. The
+ * vertices are stored as vertex_t; entries written by a build with another
+ * vertex type are treated as stale.
+ */
+
+#include "3DViever.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// Identifies cache files
+#define CACHE_MAGIC "3DVMESH"
+/// Format version, bumped whenever the layout changes
+#define CACHE_VERSION 3
+/// Detects cache files written on a machine with another byte order
+#define CACHE_BYTE_ORDER 0x01020304u
+/// Alignment of the model data inside the file
+#define CACHE_ALIGN ((size_t)64)
+/// Name of the cache directory
+#define CACHE_DIR_NAME "3DViever"
+/// Suffix of cache files kept next to the .obj file
+#define CACHE_SUFFIX ".3dvcache"
+
+/**
+ * @struct cache_header
+ * @brief Header at the start of every cache file
+ */
+typedef struct cache_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint64_t source_size;
+  int64_t source_mtime;
+  int64_t source_mtime_ns;
+  uint64_t vertex_count;
+  uint64_t polygon_count;
+  uint64_t index_count;
+  uint64_t path_length;
+  uint64_t vertex_size;
+  double bbox_min[3];
+  double bbox_max[3];
+  double centroid[3];
+} cache_header;
+
+/**
+ * @brief Fills the parts of a header that identify the source file
+ *
+ * @param path Absolute path of the .obj file
+ * @param st Status of the .obj file
+ * @param header Header to fill
+ */
+static void header_init(const char *path, const struct stat *st,
+                        cache_header *header) {
+  memset(header, 0, sizeof(cache_header));
+  memcpy(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  header->version = CACHE_VERSION;
+  header->byte_order = CACHE_BYTE_ORDER;
+  header->vertex_size = sizeof(vertex_t);
+  header->source_size = (uint64_t)st->st_size;
+#ifdef __APPLE__
+  header->source_mtime = st->st_mtimespec.tv_sec;
+  header->source_mtime_ns = st->st_mtimespec.tv_nsec;
+#else
+  header->source_mtime = st->st_mtim.tv_sec;
+  header->source_mtime_ns = st->st_mtim.tv_nsec;
+#endif
+  header->path_length = strlen(path);
+}
+
+/**
+ * @brief Returns the offset of the model data in a cache file
+ *
+ * @param header Header of the cache file
+ * @return Offset in bytes
+ */
+static size_t data_offset(const cache_header *header) {
+  return (sizeof(cache_header) + header->path_length + CACHE_ALIGN - 1) &
+         ~(CACHE_ALIGN - 1);
+}
+
+/**
+ * @brief Returns the size of the model data in a cache file
+ *
+ * @param header Header of the cache file
+ * @return Size in bytes, 0 if the counts are out of range
+ */
+static size_t data_size(const cache_header *header) {
+  size_t size = 0;
+  if (header->vertex_count < SIZE_MAX / 32 &&
+      header->polygon_count < SIZE_MAX / 32 &&
+      header->index_count < SIZE_MAX / 32)
+    size = vertex_bytes(header->vertex_count) +
+           (header->polygon_count + 1) * sizeof(uint64_t) +
+           header->index_count * sizeof(uint32_t);
+  return size;
+}
+
+/**
+ * @brief Creates a directory and its missing parents
+ *
+ * @param dir Directory path
+ * @return OK if the directory exists afterwards, ERROR otherwise
+ */
+static int make_dirs(const char *dir) {
+  int status = OK;
+  char *path = strdup(dir);
+  if (!path) status = ERROR;
+  for (char *pos = path ? path + 1 : NULL; status == OK && pos; pos++) {
+    pos = strchr(pos, '/');
+    if (pos) *pos = '\0';
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) status = ERROR;
+    if (pos) *pos = '/';
+    else
+      break;
+  }
+  free(path);
+  return status;
+}
+
+/**
+ * @brief Builds the path of the cache file of an .obj file
+ *
+ * The file name is the 64-bit FNV-1a hash of the absolute path; the path
+ * itself is stored in the file to rule out collisions.
+ *
+ * @param path Absolute path of the .obj file
+ * @param cache_dir Cache directory, NULL for the default one
+ * @return Path of the cache file to be freed by the caller, NULL on error
+ */
+static char *cache_file_name(const char *path, const char *cache_dir) {
+  char dir[PATH_MAX] = "";
+  const char *xdg = getenv("XDG_CACHE_HOME"), *home = getenv("HOME");
+  if (cache_dir)
+    snprintf(dir, sizeof(dir), "%s", cache_dir);
+  else if (xdg && *xdg)
+    snprintf(dir, sizeof(dir), "%s/" CACHE_DIR_NAME, xdg);
+  else if (home && *home)
+    snprintf(dir, sizeof(dir), "%s/.cache/" CACHE_DIR_NAME, home);
+  char *name = NULL;
+  if (*dir && make_dirs(dir) == OK) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char *pos = path; *pos; pos++)
+      hash = (hash ^ (unsigned char)*pos) * 1099511628211ULL;
+    size_t len = strlen(dir) + 32;
+    name = malloc(len);
+    if (name)
+      snprintf(name, len, "%s/%016llx.mesh", dir, (unsigned long long)hash);
+  } else if (!cache_dir) {
+    size_t len = strlen(path) + sizeof(CACHE_SUFFIX);
+    name = malloc(len);
+    if (name) snprintf(name, len, "%s" CACHE_SUFFIX, path);
+  }
+  return name;
+}
+
+/**
+ * @brief Checks the offsets and indices of a mapped cache entry
+ *
+ * @param data_obj Model pointing into the mapping
+ * @return OK if the model is consistent, ERROR otherwise
+ */
+static int check_model(const data_object *data_obj) {
+  int status = data_obj->offset_array[0] == 0 &&
+                       data_obj->offset_array[data_obj->polygon_count] ==
+                           data_obj->all_edges_count
+                   ? OK
+                   : ERROR;
+  for (size_t i = 0; status == OK && i < data_obj->polygon_count; i++)
+    if (data_obj->offset_array[i] > data_obj->offset_array[i + 1])
+      status = ERROR;
+  for (size_t i = 0; status == OK && i < data_obj->all_edges_count; i++)
+    if (data_obj->index_array[i] == 0 ||
+        data_obj->index_array[i] > data_obj->vertex_count)
+      status = ERROR;
+  return status;
+}
+
+/**
+ * @brief Maps a cache entry that matches the .obj file
+ *
+ * @param cache_name Path of the cache file
+ * @param expected Header built from the .obj file
+ * @param path Absolute path of the .obj file
+ * @param data_obj Pointer to the data_object struct, untouched on error
+ * @return OK if a valid entry was mapped, ERROR otherwise
+ */
+static int cache_open(const char *cache_name, const cache_header *expected,
+                      const char *path, data_object *data_obj) {
+  int status = OK;
+  int fd = open(cache_name, O_RDONLY);
+  struct stat st;
+  cache_header header;
+  if (fd < 0 || fstat(fd, &st) != 0 ||
+      read(fd, &header, sizeof(header)) != (ssize_t)sizeof(header))
+    status = ERROR;
+  if (status == OK &&
+      (memcmp(header.magic, expected->magic, sizeof(header.magic)) != 0 ||
+       header.version != expected->version ||
+       header.byte_order != expected->byte_order ||
+       header.source_size != expected->source_size ||
+       header.source_mtime != expected->source_mtime ||
+       header.source_mtime_ns != expected->source_mtime_ns ||
+       header.path_length != expected->path_length ||
+       header.vertex_size != expected->vertex_size ||
+       data_size(&header) == 0 ||
+       (size_t)st.st_size != data_offset(&header) + data_size(&header)))
+    status = ERROR;
+  char *data = MAP_FAILED;
+  if (status == OK) {
+    data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED ||
+        memcmp(data + sizeof(header), path, header.path_length) != 0)
+      status = ERROR;
+  }
+  if (status == OK) {
+    data_object model = {0};
+    char *vertices = data + data_offset(&header);
+    model.vertex_count = header.vertex_count;
+    model.vertex_array.matrix = (vertex_t *)vertices;
+    model.vertex_array.rows = header.vertex_count + 1;
+    model.vertex_array.colums = 3;
+    model.polygon_count = header.polygon_count;
+    model.all_edges_count = header.index_count;
+    model.offset_array =
+        (size_t *)(vertices + vertex_bytes(header.vertex_count));
+    model.index_array =
+        (unsigned int *)(model.offset_array + header.polygon_count + 1);
+    memcpy(model.bbox_min, header.bbox_min, sizeof(model.bbox_min));
+    memcpy(model.bbox_max, header.bbox_max, sizeof(model.bbox_max));
+    memcpy(model.centroid, header.centroid, sizeof(model.centroid));
+    status = check_model(&model);
+    if (status == OK) {
+      memory_reset(data_obj);
+      model.arena = data_obj->arena;
+      model.mapping = data;
+      model.mapping_size = st.st_size;
+      *data_obj = model;
+    }
+  }
+  if (status != OK && data != MAP_FAILED) munmap(data, st.st_size);
+  if (fd >= 0) close(fd);
+  return status;
+}
+
+/**
+ * @brief Writes all bytes of a buffer
+ *
+ * @param fd File descriptor
+ * @param buffer Data
+ * @param size Size in bytes
+ * @return OK if successful, ERROR otherwise
+ */
+static int write_all(int fd, const void *buffer, size_t size) {
+  int status = OK;
+  const char *pos = buffer;
+  while (status == OK && size > 0) {
+    ssize_t written = write(fd, pos, size);
+    if (written > 0) {
+      pos += written;
+      size -= written;
+    } else if (written < 0 && errno != EINTR)
+      status = ERROR;
+  }
+  return status;
+}
+
+/**
+ * @brief Stores a parsed model as a cache entry
+ *
+ * The entry is written to a temporary file with a unique name made by
+ * mkstemp() and renamed over the cache file, so threads and processes that
+ * store the same model at once never write the same file.
+ *
+ * @param cache_name Path of the cache file
+ * @param header Header built from the .obj file
+ * @param path Absolute path of the .obj file
+ * @param data_obj Parsed model
+ * @return OK if successful, ERROR otherwise
+ */
+static int cache_write(const char *cache_name, cache_header header,
+                       const char *path, const data_object *data_obj) {
+  header.vertex_count = data_obj->vertex_count;
+  header.polygon_count = data_obj->polygon_count;
+  header.index_count = data_obj->all_edges_count;
+  memcpy(header.bbox_min, data_obj->bbox_min, sizeof(header.bbox_min));
+  memcpy(header.bbox_max, data_obj->bbox_max, sizeof(header.bbox_max));
+  memcpy(header.centroid, data_obj->centroid, sizeof(header.centroid));
+  size_t len = strlen(cache_name) + 8;
+  char *tmp_name = malloc(len);
+  int status = tmp_name ? OK : ERROR;
+  int fd = -1;
+  if (status == OK) {
+    snprintf(tmp_name, len, "%s.XXXXXX", cache_name);
+    fd = mkstemp(tmp_name);
+    if (fd < 0 || fchmod(fd, 0644) != 0) status = ERROR;
+  }
+  if (status == OK) {
+    static const char zeros[CACHE_ALIGN] = {0};
+    size_t padding = data_offset(&header) - sizeof(header) - header.path_length;
+    size_t vertices = (data_obj->vertex_count + 1) * 3 * sizeof(vertex_t);
+    if (write_all(fd, &header, sizeof(header)) != OK ||
+        write_all(fd, path, header.path_length) != OK ||
+        write_all(fd, zeros, padding) != OK ||
+        write_all(fd, data_obj->vertex_array.matrix, vertices) != OK ||
+        write_all(fd, zeros, vertex_bytes(data_obj->vertex_count) - vertices) !=
+            OK ||
+        write_all(fd, data_obj->offset_array,
+                  (data_obj->polygon_count + 1) * sizeof(size_t)) != OK ||
+        write_all(fd, data_obj->index_array,
+                  data_obj->all_edges_count * sizeof(unsigned int)) != OK)
+      status = ERROR;
+  }
+  if (fd >= 0 && close(fd) != 0) status = ERROR;
+  if (status == OK && rename(tmp_name, cache_name) != 0) status = ERROR;
+  if (status != OK && fd >= 0) unlink(tmp_name);
+  free(tmp_name);
+  return status;
+}
+
+/**
+ * @brief Loads an .obj file, using the binary cache when possible
+ *
+ * A cache entry that matches the path, size and modification time of the
+ * file is mapped into memory. Otherwise the file is parsed with parse_obj()
+ * and a new entry is written; failing to write it is not an error. Stdin is
+ * never cached.
+ *
+ * @param file_name Name of the .obj file to load, "-" for stdin
+ * @param data_obj Pointer to the data_object struct, zeroed or holding a model
+ * @param options Parser and cache options, NULL for defaults
+ * @param from_cache Set to 1 if the model came from the cache, may be NULL
+ * @return OK if successful, ERROR otherwise
+ */
+int load_obj(char *file_name, data_object *data_obj,
+             const parser_options *options, int *from_cache) {
+  if (file_name == NULL || data_obj == NULL) return ERROR;
+  parser_options defaults = {0};
+  if (!options) options = &defaults;
+  if (from_cache) *from_cache = 0;
+  int status = ERROR;
+  char *path = NULL, *cache_name = NULL;
+  struct stat st;
+  cache_header header;
+  if (options->cache != CACHE_OFF && sizeof(size_t) == sizeof(uint64_t) &&
+      strcmp(file_name, "-") != 0 && stat(file_name, &st) == 0 &&
+      S_ISREG(st.st_mode) && (path = realpath(file_name, NULL)) &&
+      (cache_name = cache_file_name(path, options->cache_dir))) {
+    header_init(path, &st, &header);
+    if (cache_open(cache_name, &header, path, data_obj) == OK) {
+      status = OK;
+      if (from_cache) *from_cache = 1;
+    }
+  }
+  if (status != OK) {
+    status = parse_obj(file_name, data_obj, options);
+    if (status == OK && cache_name)
+      cache_write(cache_name, header, path, data_obj);
+  }
+  free(path);
+  free(cache_name);
+  return status;
+}
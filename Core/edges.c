@@ -0,0 +1,156 @@
+/**
+ * @file edges.c
+ * @brief Line list of the wireframe of a model
+ *
+ * Drawing every polygon as its own line loop takes one draw call per
+ * polygon, and on a closed mesh every edge is drawn twice because it is
+ * shared by two faces. This module turns all polygons into a single list of
+ * unique vertex pairs once per model, so the whole wireframe is drawn with
+ * one GL_LINES call and no edge is rasterized twice.
+ *
+ * Key features:
+ * - Edges are deduplicated with a hash table keyed on the sorted vertex pair
+ * - Edges keep the order in which they first appear in the polygons
+ * - Degenerate edges from a vertex to itself are dropped
+ * - The list is allocated from the arena of the model, the hash table is
+ *   temporary
+ */
+
+#include "3DViever.h"
+
+#include <stdint.h>
+
+/// Marks a free slot of the edge table
+#define EDGE_EMPTY UINT32_MAX
+
+/**
+ * @struct edge_table
+ * @brief Open-addressing hash set of edges
+ *
+ * slots holds indices into pairs, where the unique edges are kept in the
+ * order they were added, the smaller vertex index first.
+ */
+typedef struct edge_table {
+  uint32_t *slots;
+  size_t mask;
+  int bits;
+  unsigned int *pairs;
+  size_t count;
+} edge_table;
+
+/**
+ * @brief Returns the number of edges of a polygon
+ *
+ * A polygon with n >= 3 vertices has n edges, a two-vertex polygon is a
+ * single segment and a one-vertex polygon has no edges.
+ *
+ * @param size Number of vertices of the polygon
+ * @return Number of edges
+ */
+static size_t polygon_edges(size_t size) { return size > 2 ? size : size / 2; }
+
+/**
+ * @brief Allocates an edge table for up to capacity edges
+ *
+ * The table is kept at most two-thirds full.
+ *
+ * @param table Table to initialize
+ * @param capacity Largest number of edges that will be added
+ * @return OK if successful, ERROR otherwise
+ */
+static int edge_table_init(edge_table *table, size_t capacity) {
+  int status = capacity < EDGE_EMPTY ? OK : ERROR;
+  table->bits = 1;
+  while (((size_t)1 << table->bits) < capacity + capacity / 2) table->bits++;
+  table->mask = ((size_t)1 << table->bits) - 1;
+  table->count = 0;
+  table->slots = NULL;
+  table->pairs = NULL;
+  if (status == OK) {
+    table->slots = malloc((table->mask + 1) * sizeof(uint32_t));
+    table->pairs = malloc((capacity ? capacity : 1) * 2 * sizeof(unsigned int));
+    if (table->slots && table->pairs)
+      memset(table->slots, 0xFF, (table->mask + 1) * sizeof(uint32_t));
+    else
+      status = ERROR;
+  }
+  return status;
+}
+
+/**
+ * @brief Adds an edge unless the table already holds it
+ *
+ * @param table Edge table
+ * @param a First vertex index
+ * @param b Second vertex index
+ */
+static void edge_table_add(edge_table *table, unsigned int a, unsigned int b) {
+  if (a > b) {
+    unsigned int swap = a;
+    a = b;
+    b = swap;
+  }
+  uint64_t key = (uint64_t)a << 32 | b;
+  size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> (64 - table->bits));
+  int found = 0;
+  while (!found && table->slots[slot] != EDGE_EMPTY) {
+    const unsigned int *pair = table->pairs + 2 * (size_t)table->slots[slot];
+    found = pair[0] == a && pair[1] == b;
+    slot = (slot + 1) & table->mask;
+  }
+  if (!found) {
+    table->slots[slot] = (uint32_t)table->count;
+    table->pairs[2 * table->count] = a;
+    table->pairs[2 * table->count + 1] = b;
+    table->count++;
+  }
+}
+
+/**
+ * @brief Builds the line list of an object
+ *
+ * Fills edge_array with edges_count pairs of vertex indices, edge i joins
+ * edge_array[2 * i] and edge_array[2 * i + 1]. Every edge appears once, no
+ * matter how many polygons share it. The list is allocated from the arena of
+ * the object and replaces a previously built one.
+ *
+ * @param data_obj Pointer to the data_object struct
+ * @return OK if successful, ERROR otherwise
+ */
+int build_edges(data_object *data_obj) {
+  int status = data_obj && (data_obj->offset_array || !data_obj->polygon_count)
+                   ? OK
+                   : ERROR;
+  edge_table table = {0};
+  unsigned int *edges = NULL;
+  if (status == OK) {
+    size_t count = 0;
+    for (size_t i = 0; i < data_obj->polygon_count; i++)
+      count += polygon_edges(data_obj->offset_array[i + 1] -
+                             data_obj->offset_array[i]);
+    status = edge_table_init(&table, count);
+  }
+  if (status == OK) {
+    for (size_t i = 0; i < data_obj->polygon_count; i++) {
+      polygon_t polygon = get_polygon(data_obj, i);
+      size_t size = polygon_edges(polygon.colums);
+      for (size_t j = 0; j < size; j++) {
+        unsigned int a = polygon.polygon[j];
+        unsigned int b = polygon.polygon[(j + 1) % polygon.colums];
+        if (a != b) edge_table_add(&table, a, b);
+      }
+    }
+    edges = arena_alloc(&data_obj->arena,
+                        table.count * 2 * sizeof(unsigned int));
+    if (!edges) status = ERROR;
+  }
+  if (status == OK) {
+    if (table.count > 0)
+      memcpy(edges, table.pairs, table.count * 2 * sizeof(unsigned int));
+    data_obj->edge_array = edges;
+    data_obj->edges_count = table.count;
+  }
+  free(table.slots);
+  free(table.pairs);
+  return status;
+}
@@ -0,0 +1,133 @@
+/**
+ * @class GifEncoder
+ * @brief Encodes GIF frames on a worker thread
+ *
+ * The file is opened on the calling thread, so an unwritable path is
+ * reported at once. After that every frame is converted to indexed colors,
+ * LZW-compressed and written by the worker through the streaming QGifImage
+ * API; the caller only appends frames to a queue.
+ *
+ * Usage:
+ * - Connect progress() to a progress bar and finished() to a slot
+ * - Call begin() to open the file and start the worker
+ * - Call add_frame() for every captured frame, then finish()
+ * - In the finished() slot check ok()
+ */
+
+#include "gifencoder.h"
+
+#include <QMutexLocker>
+
+#include "QtGifImage/src/gifimage/qgifimage.h"
+
+/**
+ * @brief Constructor
+ * @param parent Parent object
+ */
+GifEncoder::GifEncoder(QObject *parent) : QThread{parent} {}
+
+/**
+ * @brief Destructor
+ * Encodes the frames still queued and closes the file
+ */
+GifEncoder::~GifEncoder() {
+  finish();
+  wait();
+  delete gif;
+}
+
+/**
+ * @brief Opens the file and starts the worker thread
+ * @param file_name Name of the .gif file
+ * @param size Size of the animation
+ * @return false if an animation is still being written or the file cannot
+ * be opened
+ */
+bool GifEncoder::begin(const QString &file_name, const QSize &size) {
+  if (isRunning()) return false;
+  delete gif;
+  gif = new QGifImage(size);
+  if (!gif->open(file_name)) {
+    delete gif;
+    gif = nullptr;
+    return false;
+  }
+  this->file_name = file_name;
+  frames.clear();
+  finishing = false;
+  result = true;
+  written = 0;
+  queued = 0;
+  start();
+  return true;
+}
+
+/**
+ * @brief Queues a frame for encoding, returns immediately
+ * @param frame Captured frame
+ * @param delay Delay of the frame in milliseconds
+ */
+void GifEncoder::add_frame(const QImage &frame, int delay) {
+  QMutexLocker locker(&mutex);
+  if (finishing || !gif) return;
+  frames.enqueue({frame, delay});
+  queued++;
+  frame_ready.wakeOne();
+}
+
+/**
+ * @brief Tells the worker that no more frames will come
+ *
+ * The worker encodes the frames already queued, closes the file and then
+ * finishes.
+ */
+void GifEncoder::finish() {
+  QMutexLocker locker(&mutex);
+  finishing = true;
+  frame_ready.wakeOne();
+}
+
+/**
+ * @brief Tells whether every frame of the last animation was written
+ */
+bool GifEncoder::ok() const {
+  QMutexLocker locker(&mutex);
+  return result;
+}
+
+/**
+ * @brief Returns the name of the last animation
+ */
+QString GifEncoder::file() const { return file_name; }
+
+/**
+ * @brief Encodes the queued frames, called on the worker thread
+ *
+ * Takes all frames queued so far with the same delay and encodes them at
+ * once, so a backlog is converted and compressed on several cores.
+ */
+void GifEncoder::run() {
+  for (;;) {
+    QList<QImage> batch;
+    int delay, total;
+    {
+      QMutexLocker locker(&mutex);
+      while (frames.isEmpty() && !finishing) frame_ready.wait(&mutex);
+      if (frames.isEmpty()) break;
+      delay = frames.head().delay;
+      while (!frames.isEmpty() && frames.head().delay == delay)
+        batch.append(frames.dequeue().image);
+      total = queued;
+    }
+    bool frames_ok = gif->writeFrames(batch, delay);
+    {
+      QMutexLocker locker(&mutex);
+      result = result && frames_ok;
+      written += batch.size();
+    }
+    emit progress(written, total);
+  }
+  bool closed = gif->close();
+  QMutexLocker locker(&mutex);
+  result = result && closed;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file gifencoder.h
+ * @brief Header file for the background GIF encoder
+ *
+ * This header file declares the GifEncoder class, which quantizes, compresses
+ * and writes GIF frames on a worker thread so that frame capture in the main
+ * window is never held up by encoding.
+ */
+
+#ifndef GIFENCODER_H
+#define GIFENCODER_H
+
+#include <QImage>
+#include <QMutex>
+#include <QQueue>
+#include <QSize>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+class QGifImage;
+
+/**
+ * @class GifEncoder
+ * @brief Worker thread that writes one GIF animation at a time
+ *
+ * Frames are queued by add_frame() and encoded in order as the worker gets
+ * to them, so the caller can keep capturing at its own rate. The thread
+ * finishes once finish() has been called and the queue is empty.
+ */
+class GifEncoder : public QThread {
+  Q_OBJECT
+ public:
+  explicit GifEncoder(QObject *parent = nullptr);
+  ~GifEncoder() override;
+
+  bool begin(const QString &file_name, const QSize &size);
+  void add_frame(const QImage &frame, int delay);
+  void finish();
+  bool ok() const;
+  QString file() const;
+
+ signals:
+  void progress(int written, int queued);
+
+ protected:
+  void run() override;
+
+ private:
+  struct queued_frame {
+    QImage image;
+    int delay;
+  };
+
+  QGifImage *gif = nullptr;
+  QString file_name;
+  mutable QMutex mutex;
+  QWaitCondition frame_ready;
+  QQueue<queued_frame> frames;
+  bool finishing = false;
+  bool result = true;
+  int written = 0;
+  int queued = 0;
+};
+
+#endif  // GIFENCODER_H
@@ -11,6 +11,15 @@
  * - Allows customization of line types, thickness, and colors
  * - Enables point cloud visualization with smooth shading
  * - Handles vertex and polygon data for efficient rendering
+ * - Keeps the model in vertex and index buffer objects, uploaded only when
+ *   the model changes
+ * - Draws the whole wireframe with a single call from the line list built
+ *   by build_edges()
+ * - Optional overlay with the frame time and its rolling percentiles, the
+ *   work submitted per frame, the load times and the work done per second
+ * - GPU time of the frames from timer queries, read without stalling
+ * - Dump of the recorded frames as CSV
+ * - Redraws only when the model matrix has really changed
  *
  * Usage:
  * - Initialize OpenGL functions in initializeGL()
@@ -22,7 +31,25 @@
 
 #include <QtGui/qevent.h>
 
+#include <QFile>
+#include <QPainter>
+#include <QTextStream>
 #include <QtDebug>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
+// Тип вершин для glVertexPointer, совпадает с vertex_t
+#ifdef VERTEX_FLOAT
+#define GL_VERTEX_TYPE GL_FLOAT
+#else
+#define GL_VERTEX_TYPE GL_DOUBLE
+#endif  // VERTEX_FLOAT
+
+// Сколько последних кадров хранится для перцентилей и CSV
+static const int frame_history_size = 1000;
+// Как часто обновляются счётчики за секунду и время кадра в окне, мс
+static const int stats_refresh_ms = 1000;
 
 /**
  * @brief Constructor
@@ -34,45 +61,451 @@ GLWid::GLWid(QWidget *parent) : QOpenGLWidget{parent} {}
  * @brief Destructor
  * Frees allocated memory
  */
-GLWid::~GLWid() { memory_free(&data_obj); }
+GLWid::~GLWid() {
+  makeCurrent();
+  gpu_timer.destroy();
+  vertex_buffer.destroy();
+  index_buffer.destroy();
+  doneCurrent();
+  memory_free(&data_obj);
+}
+
+/**
+ * @brief Marks the model as changed so that it is uploaded again
+ *
+ * Must be called whenever data_obj is replaced or its vertices are modified.
+ * Transformations through model_matrix do not need it.
+ */
+void GLWid::geometry_changed() {
+  geometry_dirty = true;
+  update();
+}
+
+/**
+ * @brief Requests a frame after a change of model_matrix
+ *
+ * Nothing is drawn if the matrix is the one the last frame was drawn with,
+ * for example after a rotation by zero degrees.
+ *
+ * @param nsec Time the change took in nanoseconds
+ */
+void GLWid::transform_changed(qint64 nsec) {
+  counters.transforms++;
+  counters.transform_ns += nsec;
+  if (memcmp(model_matrix, drawn_matrix, sizeof(model_matrix)) != 0) update();
+}
+
+/**
+ * @brief Moves the model
+ * @param dx Offset along the X-axis
+ * @param dy Offset along the Y-axis
+ * @param dz Offset along the Z-axis
+ */
+void GLWid::move_model(double dx, double dy, double dz) {
+  QElapsedTimer timer;
+  timer.start();
+  model_move(model_matrix, dx, dy, dz);
+  transform_changed(timer.nsecsElapsed());
+}
+
+/**
+ * @brief Rotates the model around the X-axis
+ * @param angle Rotation angle in degrees
+ */
+void GLWid::rotate_model_x(double angle) {
+  QElapsedTimer timer;
+  timer.start();
+  model_rotate_x(model_matrix, angle);
+  transform_changed(timer.nsecsElapsed());
+}
+
+/**
+ * @brief Rotates the model around the Y-axis
+ * @param angle Rotation angle in degrees
+ */
+void GLWid::rotate_model_y(double angle) {
+  QElapsedTimer timer;
+  timer.start();
+  model_rotate_y(model_matrix, angle);
+  transform_changed(timer.nsecsElapsed());
+}
+
+/**
+ * @brief Rotates the model around the Z-axis
+ * @param angle Rotation angle in degrees
+ */
+void GLWid::rotate_model_z(double angle) {
+  QElapsedTimer timer;
+  timer.start();
+  model_rotate_z(model_matrix, angle);
+  transform_changed(timer.nsecsElapsed());
+}
+
+/**
+ * @brief Scales the model
+ * @param factor Scale factor
+ */
+void GLWid::scale_model(double factor) {
+  QElapsedTimer timer;
+  timer.start();
+  model_scale(model_matrix, factor);
+  transform_changed(timer.nsecsElapsed());
+}
+
+/**
+ * @brief Returns the model to its original position, rotation and size
+ */
+void GLWid::reset_model() {
+  QElapsedTimer timer;
+  timer.start();
+  model_identity(model_matrix);
+  transform_changed(timer.nsecsElapsed());
+}
+
+/**
+ * @brief Switches between buffer objects and client-side arrays
+ *
+ * Client-side arrays make the driver read the whole model on every frame;
+ * they are kept to compare the frame times.
+ *
+ * @param use Whether to draw from buffer objects
+ */
+void GLWid::set_use_buffers(bool use) {
+  use_buffers = use;
+  geometry_changed();
+}
+
+/**
+ * @brief Uploads the model into the vertex and index buffers
+ *
+ * Falls back to client-side arrays if the buffers cannot be created or the
+ * model does not fit into them.
+ */
+void GLWid::upload_geometry() {
+  geometry_dirty = false;
+  buffers_ready = false;
+  const void *vertices = data_obj.vertex_array.matrix;
+  size_t vertex_size = sizeof(vertex_t);
+  if (!vertices) {
+    vertices = data_obj.quantized.positions;
+    vertex_size = sizeof(int16_t);
+  }
+  size_t vertex_bytes = (data_obj.vertex_count + 1) * 3 * vertex_size;
+  size_t index_bytes = data_obj.edges_count * 2 * sizeof(unsigned int);
+  if (use_buffers && vertices && vertex_bytes <= INT_MAX &&
+      index_bytes <= INT_MAX &&
+      (vertex_buffer.isCreated() || vertex_buffer.create()) &&
+      (index_buffer.isCreated() || index_buffer.create())) {
+    vertex_buffer.bind();
+    vertex_buffer.allocate(vertices, static_cast<int>(vertex_bytes));
+    vertex_buffer.release();
+    index_buffer.bind();
+    index_buffer.allocate(data_obj.edge_array, static_cast<int>(index_bytes));
+    index_buffer.release();
+    buffers_ready = true;
+    counters.uploads++;
+  }
+}
 
 /**
  * @brief Initializes OpenGL functions
+ *
+ * Also creates the timer query, which fails without GL_ARB_timer_query.
  */
 void GLWid::initializeGL() {
   initializeOpenGLFunctions();
-  glEnable(GL_DEPTH_TEST);
+  gpu_timer.create();
 }
 
 /**
  * @brief Paints the OpenGL scene
+ *
+ * The model is drawn from the buffer objects, which are refreshed first if
+ * it has changed. Models without edges, such as point clouds, still get
+ * their point pass.
+ *
+ * The CPU and the GPU time of a frame are recorded separately. The GPU time
+ * comes from a timer query that is only read once its result is available,
+ * so the CPU never waits for the GPU, and is stored with the frame that
+ * issued the query. Without timer queries the frame waits for the rasterizer
+ * with glFinish(), but only while the overlay is shown. The last CPU and GPU
+ * times are sent with frame_drawn() once per stats_refresh_ms.
  */
 void GLWid::paintGL() {
+  QElapsedTimer timer;
+  timer.start();
+  bool gpu_timing = false;
+  if (gpu_timer.isCreated()) {
+    if (gpu_pending && gpu_timer.isResultAvailable()) {
+      gpu_ms = gpu_timer.waitForResult() / 1e6;
+      gpu_pending = false;
+      record_gpu_time(gpu_frame, gpu_ms);
+    }
+    if (!gpu_pending) {
+      gpu_timer.begin();
+      gpu_frame = frame_number;
+      gpu_timing = true;
+    }
+  }
+  if (geometry_dirty) upload_geometry();
+  draw_calls = 0;
+  vertices_drawn = indices_drawn = 0;
+  counters.repaints++;
+  memcpy(drawn_matrix, model_matrix, sizeof(model_matrix));
+  // QPainter оверлея выключает тест глубины, поэтому он включается каждый кадр
+  glEnable(GL_DEPTH_TEST);
   glClearColor(background_color.redF(), background_color.greenF(),
                background_color.blueF(), 1);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   glMatrixMode(GL_PROJECTION);
   glLoadIdentity();
   select_projection();
+  glMatrixMode(GL_MODELVIEW);
+  glLoadMatrixd(model_matrix);
   select_thickness();
   select_size_points();
   select_line_type();
-  if (data_obj.polygon_count != 0) {
-    glVertexPointer(3, GL_DOUBLE, 0, data_obj.vertex_array.matrix);
+  if (data_obj.vertex_count != 0) {
+    // С буферами указатели становятся смещениями внутри них
+    const void *indices = buffers_ready ? nullptr : data_obj.edge_array;
+    if (buffers_ready) {
+      vertex_buffer.bind();
+      index_buffer.bind();
+    }
+    if (data_obj.vertex_array.matrix) {
+      glVertexPointer(3, GL_VERTEX_TYPE, 0,
+                      buffers_ready ? nullptr : data_obj.vertex_array.matrix);
+    } else {
+      // 16-битные вершины декодируются матрицей: origin + position * step
+      const quantized_t &quantized = data_obj.quantized;
+      glTranslated(quantized.origin[0], quantized.origin[1],
+                   quantized.origin[2]);
+      glScaled(quantized.step[0], quantized.step[1], quantized.step[2]);
+      glVertexPointer(3, GL_SHORT, 0,
+                      buffers_ready ? nullptr : quantized.positions);
+    }
     glEnableClientState(GL_VERTEX_ARRAY);
-    glColor3f(line_color.redF(), line_color.greenF(), line_color.blueF());
-    for (int i = 0; i < data_obj.polygon_count; i++) {
-      glDrawElements(GL_LINE_LOOP, data_obj.polygon_array[i].colums,
-                     GL_UNSIGNED_INT, data_obj.polygon_array[i].polygon);
+    // Облако точек из одних строк v рисуется без линий
+    if (data_obj.edges_count != 0) {
+      glColor3f(line_color.redF(), line_color.greenF(), line_color.blueF());
+      glDrawElements(GL_LINES, data_obj.edges_count * 2, GL_UNSIGNED_INT,
+                     indices);
+      draw_calls++;
+      vertices_drawn += data_obj.vertex_count;
+      indices_drawn += data_obj.edges_count * 2;
     }
     if (type_line == 0) {
       glDisable(GL_LINE_STIPPLE);
     }
     if (type_point != 0) select_type_point();
     glDisableClientState(GL_VERTEX_ARRAY);
+    if (buffers_ready) {
+      index_buffer.release();
+      vertex_buffer.release();
+    } else {
+      counters.uploads++;  // Клиентские массивы читаются каждый кадр
+    }
   }
-  glMatrixMode(GL_MODELVIEW);
-  glLoadIdentity();
+  if (gpu_timing) {
+    gpu_timer.end();
+    gpu_pending = true;
+  } else if (!gpu_timer.isCreated() && show_stats) {
+    glFinish();
+  }
+  cpu_ms = timer.nsecsElapsed() / 1e6;
+  record_frame();
+  if (!rate_clock.isValid() || rate_clock.elapsed() >= stats_refresh_ms) {
+    double seconds = rate_clock.isValid() ? rate_clock.elapsed() / 1000.0 : 1;
+    rates = {qRound(counters.input / seconds),
+             qRound(counters.transforms / seconds),
+             qRound64(counters.transform_ns / seconds),
+             qRound(counters.repaints / seconds),
+             qRound(counters.uploads / seconds)};
+    counters = frame_counters();
+    rate_clock.start();
+    emit frame_drawn(cpu_ms, gpu_ms);
+  }
+  if (show_stats) draw_stats();
+}
+
+/**
+ * @brief Stores the statistics of the frame just drawn
+ *
+ * The last frame_history_size frames are kept, the oldest is overwritten.
+ */
+void GLWid::record_frame() {
+  frame_record record = {cpu_ms, -1, draw_calls, vertices_drawn,
+                         indices_drawn};
+  if (history.size() < frame_history_size)
+    history.append(record);
+  else
+    history[frame_number % frame_history_size] = record;
+  frame_number++;
+}
+
+/**
+ * @brief Stores the GPU time of an earlier frame once its query has finished
+ *
+ * Nothing is stored if the frame has already left the history.
+ *
+ * @param frame Number of the frame that issued the query
+ * @param msec GPU time in milliseconds
+ */
+void GLWid::record_gpu_time(qint64 frame, double msec) {
+  if (frame < frame_number && frame >= frame_number - history.size())
+    history[frame % frame_history_size].gpu_msec = msec;
+}
+
+/**
+ * @brief Returns a percentile of the recorded CPU or GPU frame times
+ *
+ * Frames without a GPU time are left out of the GPU percentiles.
+ *
+ * @param history Recorded frames
+ * @param gpu Whether to use the GPU instead of the CPU times
+ * @param fraction Percentile as a fraction, 0.5 for the median
+ * @param count Set to the number of frames the percentile is taken over
+ * @return Frame time in milliseconds, 0 if no frame has a time
+ */
+static double frame_percentile(const QVector<GLWid::frame_record> &history,
+                               bool gpu, double fraction, int *count) {
+  QVector<double> times;
+  times.reserve(history.size());
+  for (const GLWid::frame_record &record : history) {
+    double msec = gpu ? record.gpu_msec : record.cpu_msec;
+    if (msec >= 0) times.append(msec);
+  }
+  *count = static_cast<int>(times.size());
+  double value = 0;
+  if (!times.isEmpty()) {
+    auto nth = times.begin() + qMin<qsizetype>(times.size() - 1,
+                                               fraction * times.size());
+    std::nth_element(times.begin(), nth, times.end());
+    value = *nth;
+  }
+  return value;
+}
+
+/**
+ * @brief Draws the overlay with the statistics of the viewer
+ *
+ * Shows the last CPU and GPU frame times and their medians and 99th
+ * percentiles over the recorded frames, what the last frame submitted, how
+ * long the stages of
+ * the last load took and the work done per second. The text is drawn in the
+ * inverse of the background color so that it stays readable on any
+ * background.
+ */
+void GLWid::draw_stats() {
+  int cpu_frames = 0, gpu_frames = 0;
+  double cpu_p50 = frame_percentile(history, false, 0.5, &cpu_frames);
+  double cpu_p99 = frame_percentile(history, false, 0.99, &cpu_frames);
+  double gpu_p50 = frame_percentile(history, true, 0.5, &gpu_frames);
+  double gpu_p99 = frame_percentile(history, true, 0.99, &gpu_frames);
+  QString gpu_text =
+      gpu_frames > 0
+          ? QString("GPU: %1 ms, p50 %2 ms, p99 %3 ms over %4 frames\n")
+                .arg(gpu_ms, 0, 'f', 2)
+                .arg(gpu_p50, 0, 'f', 2)
+                .arg(gpu_p99, 0, 'f', 2)
+                .arg(gpu_frames)
+          : QString("GPU: not measured\n");
+  QString text =
+      QString("CPU: %1 ms, p50 %2 ms, p99 %3 ms over %4 frames\n")
+          .arg(cpu_ms, 0, 'f', 2)
+          .arg(cpu_p50, 0, 'f', 2)
+          .arg(cpu_p99, 0, 'f', 2)
+          .arg(cpu_frames) +
+      gpu_text +
+      QString("Draw calls: %1, vertices: %2, indices: %3\n")
+          .arg(draw_calls)
+          .arg(vertices_drawn)
+          .arg(indices_drawn) +
+      QString("Load: parse with bounding box %1 ms, quantize %2 ms, "
+              "edges %3 ms\n")
+          .arg(load_stats.load, 0, 'f', 1)
+          .arg(load_stats.quantize, 0, 'f', 1)
+          .arg(load_stats.edges, 0, 'f', 1) +
+      QString("Per second: %1 input, %2 transforms (%3 us), %4 repaints, "
+              "%5 vertex uploads")
+          .arg(rates.input)
+          .arg(rates.transforms)
+          .arg(rates.transform_ns / 1e3, 0, 'f', 1)
+          .arg(rates.repaints)
+          .arg(rates.uploads);
+  QPainter painter(this);
+  painter.setPen(QColor(255 - background_color.red(),
+                        255 - background_color.green(),
+                        255 - background_color.blue()));
+  painter.drawText(rect().adjusted(8, 8, -8, -8), Qt::AlignLeft | Qt::AlignTop,
+                   text);
+}
+
+/**
+ * @brief Writes the recorded frames to a CSV file
+ *
+ * The file starts with comment lines holding the load times and the rates
+ * of the last second, followed by one row per recorded frame, oldest first.
+ * gpu_ms is empty for frames without a GPU time.
+ *
+ * @param file_name Name of the CSV file
+ * @return Whether the file was written
+ */
+bool GLWid::save_stats(const QString &file_name) const {
+  QFile file(file_name);
+  bool saved = file.open(QIODevice::WriteOnly | QIODevice::Text);
+  if (saved) {
+    QTextStream out(&file);
+    out << "# load_ms," << load_stats.load << ",quantize_ms,"
+        << load_stats.quantize << ",edges_ms," << load_stats.edges << "\n";
+    out << "# input_per_s," << rates.input << ",transforms_per_s,"
+        << rates.transforms << ",transform_us_per_s,"
+        << rates.transform_ns / 1e3 << ",repaints_per_s," << rates.repaints
+        << ",uploads_per_s," << rates.uploads << "\n";
+    out << "frame,cpu_ms,gpu_ms,draw_calls,vertices,indices\n";
+    qint64 first = frame_number - history.size();
+    for (qint64 i = first; i < frame_number; i++) {
+      const frame_record &record = history[i % frame_history_size];
+      out << i << "," << record.cpu_msec << ",";
+      if (record.gpu_msec >= 0) out << record.gpu_msec;
+      out << "," << record.draw_calls << "," << record.vertices << ","
+          << record.indices << "\n";
+    }
+    saved = out.status() == QTextStream::Ok;
+  }
+  return saved;
+}
+
+/**
+ * @brief Renders the model on the CPU with the current view settings
+ *
+ * Uses soft_render(), so the image needs no OpenGL context and matches what
+ * paintGL() draws for the same size.
+ *
+ * @param size Size of the image in pixels
+ * @return Rendered image, null if rendering failed
+ */
+QImage GLWid::render_image(const QSize &size) const {
+  QImage image(size, QImage::Format_RGBA8888);
+  render_settings settings = {
+      size.width(),
+      size.height(),
+      projection,
+      type_line,
+      type_point,
+      thickness,
+      size_points,
+      {line_color.redF(), line_color.greenF(), line_color.blueF()},
+      {points_color.redF(), points_color.greenF(), points_color.blueF()},
+      {background_color.redF(), background_color.greenF(),
+       background_color.blueF()},
+      model_matrix,
+      max_vertex_value,
+      0};
+  // Строки QImage выровнены по 4 байтам, при RGBA отступов между ними нет
+  if (image.isNull() || soft_render(&data_obj, &settings, image.bits()) != OK)
+    image = QImage();
+  return image;
 }
 
 /**
@@ -119,6 +552,8 @@ void GLWid::select_type_point() {
   }
   glColor3f(points_color.redF(), points_color.greenF(), points_color.blueF());
   glDrawArrays(GL_POINTS, 1, data_obj.vertex_count);
+  draw_calls++;
+  vertices_drawn += data_obj.vertex_count;
   glDisable(GL_POINT_SMOOTH);
   if (type_point == 1) {
     glDisable(GL_POINT);
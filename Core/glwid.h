@@ -12,13 +12,16 @@
 
 #define GL_SILENCE_DEPRECATION
 
+#include <QElapsedTimer>
+#include <QImage>
+#include <QOpenGLBuffer>
 #include <QOpenGLFunctions>
+#include <QOpenGLTimerQuery>
 #include <QOpenGLWidget>
 #include <QWidget>
+#include <QVector>
 
-extern "C" {
-#include "3DViever.h"
-}
+#include "modelloader.h"
 
 /**
  * @class GLWid
@@ -33,8 +36,10 @@ class GLWid : public QOpenGLWidget, protected QOpenGLFunctions {
   Q_OBJECT
  public:
   explicit GLWid(QWidget *parent = nullptr);
-  data_object data_obj = {0, NULL, 0, 0, 0, 0};
-  double max_vertex_value;
+  data_object data_obj = {};
+  double max_vertex_value = 1;
+  // Поворот, сдвиг и масштаб модели, по столбцам как для glLoadMatrixd
+  double model_matrix[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
   int scale = 50;
   int moveX = 0, moveY = 0, moveZ = 0;
   double cur_moveX = 0, cur_moveY = 0, cur_moveZ = 0;
@@ -45,12 +50,24 @@ class GLWid : public QOpenGLWidget, protected QOpenGLFunctions {
   double thickness = 1;
   double size_points = 1;
   int format = 0;
+  bool show_stats = false;  // Оверлей со статистикой кадра, F3
+  load_times load_stats;    // Время загрузки текущей модели
   QColor line_color = QColor(255, 255, 0);
   QColor points_color = QColor(0, 0, 255);
   QColor background_color = QColor(0, 0, 0);
 
   void initializeGL() override;
   void paintGL() override;
+  void geometry_changed();
+  void move_model(double dx, double dy, double dz);
+  void rotate_model_x(double angle);
+  void rotate_model_y(double angle);
+  void rotate_model_z(double angle);
+  void scale_model(double factor);
+  void reset_model();
+  void set_use_buffers(bool use);
+  bool save_stats(const QString &file_name) const;
+  QImage render_image(const QSize &size) const;
   void select_projection();
   void select_line_type();
   void select_thickness();
@@ -59,11 +76,73 @@ class GLWid : public QOpenGLWidget, protected QOpenGLFunctions {
 
   QPoint lastPos;  // Последняя позиция курсора мыши
 
- private:
-  void get_max_vertex();
+  /**
+   * @struct frame_counters
+   * @brief Work done by the viewer, counted per second
+   *
+   * input counts mouse events, transforms changes of the model matrix and
+   * transform_ns the time spent on them, repaints drawn frames and uploads
+   * copies of the vertices to the GPU, the only remaining pass over all
+   * vertices.
+   */
+  struct frame_counters {
+    int input = 0;
+    int transforms = 0;
+    qint64 transform_ns = 0;
+    int repaints = 0;
+    int uploads = 0;
+  };
+  frame_counters counters;  // Счётчики текущей секунды
+  frame_counters rates;     // Счётчики последней полной секунды
+
+  /**
+   * @struct frame_record
+   * @brief Work of one frame, kept for the percentiles and the CSV dump
+   *
+   * gpu_msec is negative until the timer query issued by the frame has
+   * finished, and stays so for frames that issued no query.
+   */
+  struct frame_record {
+    double cpu_msec;
+    double gpu_msec;
+    int draw_calls;
+    qint64 vertices;
+    qint64 indices;
+  };
+
+ signals:
+  void frame_drawn(double cpu_msec, double gpu_msec);
 
  private:
   ~GLWid() override;
+  void upload_geometry();
+  void transform_changed(qint64 nsec);
+  void record_frame();
+  void record_gpu_time(qint64 frame, double msec);
+  void draw_stats();
+
+  // Вершины и индексы модели в памяти видеокарты
+  QOpenGLBuffer vertex_buffer{QOpenGLBuffer::VertexBuffer};
+  QOpenGLBuffer index_buffer{QOpenGLBuffer::IndexBuffer};
+  bool use_buffers = true;
+  bool buffers_ready = false;
+  bool geometry_dirty = true;
+  // Статистика последнего кадра для оверлея
+  int draw_calls = 0;
+  qint64 vertices_drawn = 0;
+  qint64 indices_drawn = 0;
+  double cpu_ms = 0;
+  // Время видеокарты по GL_TIME_ELAPSED, результат читается без ожидания
+  QOpenGLTimerQuery gpu_timer;
+  bool gpu_pending = false;
+  qint64 gpu_frame = 0;  // Номер кадра, начавшего запрос
+  double gpu_ms = -1;    // Последнее полученное время, -1 если его нет
+  // Последние кадры по кругу, номер следующего кадра
+  QVector<frame_record> history;
+  qint64 frame_number = 0;
+  // Матрица, с которой нарисован последний кадр
+  double drawn_matrix[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+  QElapsedTimer rate_clock;
 };
 
 #endif  // GLWID_H
@@ -23,9 +23,10 @@
 #include <QtDebug>
 
 #include "./ui_mainwindow.h"
-#include "QtGifImage/src/gifimage/qgifimage.h"
 #include "glwid.h"
 
+static const int gif_frame_count = 50;  // 10 кадров в секунду * 5 сек
+
 /**
  * Constructor for the main window of the 3D viewer application.
  *
@@ -43,9 +44,17 @@ MainWindow::MainWindow(QWidget* parent)
       new QSettings(QCoreApplication::applicationDirPath() + "/settings.ini",
                     QSettings::IniFormat, this);
   timer = new QTimer(this);
+  input_timer = new QTimer(this);
+  input_timer->setSingleShot(true);
+  qreal refresh_rate = screen()->refreshRate();
+  input_timer->setInterval(refresh_rate > 0 ? qRound(1000 / refresh_rate) : 16);
+  loader = new ModelLoader(this);
+  gif_encoder = new GifEncoder(this);
   load_settings();
   parameters();
   ft_connect();
+  set_loading(false);
+  ui->gifProgress->setVisible(false);
 }
 
 /**
@@ -56,6 +65,8 @@ MainWindow::MainWindow(QWidget* parent)
  */
 MainWindow::~MainWindow() {
   save_settings();
+  delete gif_encoder;
+  delete loader;
   memory_free(&ui->widget->data_obj);
   delete timer;
   delete settings;
@@ -165,6 +176,15 @@ void MainWindow::ft_connect() {
   connect(ui->jpegImage, SIGNAL(clicked()), this, SLOT(jpegImage_clicked()));
   connect(ui->gif, SIGNAL(clicked()), this, SLOT(gif_clicked()));
   connect(timer, &QTimer::timeout, this, &MainWindow::save_gif);
+  connect(gif_encoder, &GifEncoder::progress, this, &MainWindow::gif_progress);
+  connect(gif_encoder, &QThread::finished, this, &MainWindow::gif_finished);
+  connect(input_timer, &QTimer::timeout, this, &MainWindow::apply_input);
+  connect(ui->cancelLoad, SIGNAL(clicked()), this, SLOT(cancelLoad_clicked()));
+  connect(loader, &ModelLoader::progress, this, &MainWindow::load_progress);
+  connect(loader, &QThread::finished, this, &MainWindow::load_finished);
+  connect(ui->widget, &GLWid::frame_drawn, this, &MainWindow::show_frame_time);
+  connect(ui->useBuffers, &QCheckBox::toggled, ui->widget,
+          &GLWid::set_use_buffers);
 }
 
 /**
@@ -207,50 +227,140 @@ void MainWindow::openFile_clicked() {
 /**
  * Handles the click event for processing and displaying a selected .obj file.
  *
- * Resets transformations, reads the selected .obj file, parses its contents,
- * updates UI elements with file information, and displays the 3D model.
- *
- * @note If the file cannot be parsed, an error message is displayed.
+ * Starts loading the selected .obj file on the worker thread. The window
+ * stays responsive meanwhile: the progress bar shows how much of the file has
+ * been parsed and the Cancel button aborts the load. The current model stays
+ * on screen until the new one is complete.
  */
 void MainWindow::run_clicked() {
-  reset();
   QString file =
       ui->fileName->text();  // получаем имя файла из информации о файле
-  QByteArray file_nameUtf8 = file.toUtf8();  // кодировка UTF8
-  char* file_name = file_nameUtf8.data();  // массив символов имени файла
-  char* obj_name = strrchr(file_name, '/') + 1;
-  if (QFile::exists(file_name)) {  // если имя файла есть
-    memory_free(&ui->widget->data_obj);
-    ui->widget->data_obj = {0, NULL, 0, 0, 0, 0};
-    if (parser(file_name, &ui->widget->data_obj) == OK) {
-      ui->valueInfoFileName->setText(obj_name);
-      get_max_vertex();
-      ui->widget->max_vertex_value = max_vertex;
-      ui->widget->update();
-    } else {
-      QMessageBox::information(this, "ERROR", "Select the correct obj-file");
-    }
+  if (!loader->isRunning() && QFile::exists(file)) {
+    set_loading(true);
+    loader->load(file, ui->quantize->isChecked());
+  }
+}
+
+/**
+ * Handles the click event for canceling the running load.
+ */
+void MainWindow::cancelLoad_clicked() { loader->cancel(); }
+
+/**
+ * Shows the progress of the running load.
+ *
+ * @param done Number of bytes parsed.
+ * @param total Size of the file, 0 if it is not known.
+ */
+void MainWindow::load_progress(qint64 done, qint64 total) {
+  if (total > 0) {
+    ui->loadProgress->setRange(0, 100);
+    ui->loadProgress->setValue(static_cast<int>(done * 100 / total));
+  } else {
+    ui->loadProgress->setRange(0, 0);
   }
+}
+
+/**
+ * Displays the model once the worker thread has finished loading it.
+ *
+ * Resets transformations, swaps the new model into the widget, updates UI
+ * elements with file information and redraws the 3D model. The model is
+ * taken from the binary cache when a valid entry exists; the time of the last
+ * cold (parsed) and warm (cached) open of the file is shown in the info
+ * panel. A canceled load leaves the current model as it is.
+ *
+ * @note If the file cannot be parsed, an error message is displayed.
+ */
+void MainWindow::load_finished() {
+  set_loading(false);
+  if (loader->canceled()) return;
+  QString file = loader->file();
+  QString obj_name = file.mid(file.lastIndexOf('/') + 1);
+  reset();
+  if (loader->status() == OK) {
+    loader->take(&ui->widget->data_obj);
+    ui->widget->reset_model();
+    ui->widget->load_stats = loader->times();
+    show_open_time(file, loader->from_cache(), loader->elapsed_ms());
+    ui->valueInfoFileName->setText(obj_name);
+    ui->widget->max_vertex_value = model_extent(&ui->widget->data_obj);
+  } else {
+    memory_reset(&ui->widget->data_obj);
+    QMessageBox::information(this, "ERROR", "Select the correct obj-file");
+  }
+  ui->widget->geometry_changed();
   ui->valueNumderVertices->setText(
       QString::number(ui->widget->data_obj.vertex_count));
   ui->valueNumberEdges->setText(
-      QString::number(ui->widget->data_obj.all_edges_count));
+      QString::number(ui->widget->data_obj.edges_count));
+  show_memory();
 }
 
 /**
- * Finds the maximum absolute vertex coordinate value in the 3D model.
+ * Shows how long the last frame took on the CPU and the GPU.
  *
- * Iterates through the vertex array to find the largest absolute coordinate
- * value among all vertices. This maximum value is stored in the `max_vertex`
- * variable and used for scaling purposes.
+ * @param cpu_msec CPU time of the frame in milliseconds.
+ * @param gpu_msec Last measured GPU time in milliseconds, negative if none.
  */
-void MainWindow::get_max_vertex() {
-  max_vertex = -1;
-  for (int i = 3; i < (ui->widget->data_obj.vertex_count + 1) * 3; i++) {
-    if (abs(ui->widget->data_obj.vertex_array.matrix[i]) > max_vertex) {
-      max_vertex = abs(ui->widget->data_obj.vertex_array.matrix[i]);
-    }
+void MainWindow::show_frame_time(double cpu_msec, double gpu_msec) {
+  QString text = "CPU " + QString::number(cpu_msec, 'f', 2) + " ms";
+  if (gpu_msec >= 0)
+    text += ", GPU " + QString::number(gpu_msec, 'f', 2) + " ms";
+  ui->valueFrameTime->setText(text);
+}
+
+/**
+ * Switches the controls between the idle and the loading state.
+ *
+ * @param loading Whether a load is running.
+ */
+void MainWindow::set_loading(bool loading) {
+  ui->run->setEnabled(!loading);
+  ui->loadProgress->setRange(0, 100);
+  ui->loadProgress->setValue(0);
+  ui->loadProgress->setVisible(loading);
+  ui->cancelLoad->setVisible(loading);
+}
+
+/**
+ * Shows how long opening the current file took.
+ *
+ * Keeps the last cold and warm open time of the file; both are cleared when
+ * another file is opened.
+ *
+ * @param file Name of the opened file.
+ * @param from_cache Whether the model came from the binary cache.
+ * @param msec Open time in milliseconds.
+ */
+void MainWindow::show_open_time(const QString& file, bool from_cache,
+                                double msec) {
+  if (file != timed_file) {
+    timed_file = file;
+    cold_open_ms = warm_open_ms = -1;
   }
+  (from_cache ? warm_open_ms : cold_open_ms) = msec;
+  auto format = [](double value) {
+    return value < 0 ? QString("-") : QString::number(value, 'f', 1) + " ms";
+  };
+  ui->valueOpenTime->setText(format(cold_open_ms) + " / " +
+                             format(warm_open_ms));
+}
+
+/**
+ * Shows how much memory the current model takes.
+ *
+ * For a model with 16-bit vertices the largest difference between a decoded
+ * and an original coordinate is shown as well.
+ */
+void MainWindow::show_memory() {
+  const data_object &model = ui->widget->data_obj;
+  ui->valueMemory->setText(
+      QString::number(model_memory(&model) / 1048576.0, 'f', 1) + " MB");
+  ui->valueQuantError->setText(
+      model.quantized.positions
+          ? QString::number(model.quantized.max_error, 'g', 3)
+          : QString("-"));
 }
 
 /**
@@ -268,6 +378,7 @@ void MainWindow::save_settings() {
   settings->setValue("line_color", ui->widget->line_color);
   settings->setValue("points_color", ui->widget->points_color);
   settings->setValue("background_color", ui->widget->background_color);
+  settings->setValue("quantize", ui->quantize->isChecked());
 }
 
 /**
@@ -286,6 +397,7 @@ void MainWindow::load_settings() {
   ui->widget->line_color = settings->value("line_color").toString();
   ui->widget->points_color = settings->value("points_color").toString();
   ui->widget->background_color = settings->value("background_color").toString();
+  ui->quantize->setChecked(settings->value("quantize").toBool());
 }
 
 /**
@@ -331,11 +443,10 @@ void MainWindow::tabWidget_currentChanged(int index) { resetAll_clicked(); }
  * @param value The new rescaling value.
  */
 void MainWindow::rescaling_valueChanged(int value) {
-  if (value != 0 && ui->widget->data_obj.vertex_array.matrix) {
-    scale(&ui->widget->data_obj, value, ui->widget->scale);
+  if (value != 0 && ui->widget->data_obj.vertex_count) {
+    ui->widget->scale_model((double)value / ui->widget->scale);
     ui->widget->scale = value;
     ui->rescaling_input->setValue(50);
-    ui->widget->update();
   }
 }
 
@@ -349,12 +460,11 @@ void MainWindow::rescaling_valueChanged(int value) {
  * @param arg1 The new input value for rescaling.
  */
 void MainWindow::on_rescaling_input_valueChanged(int arg1) {
-  if (ui->widget->data_obj.vertex_array.matrix) {
+  if (ui->widget->data_obj.vertex_count) {
     if (arg1 == 0) arg1 = 1;
-    scale(&ui->widget->data_obj, arg1, ui->widget->scale);
+    ui->widget->scale_model((double)arg1 / ui->widget->scale);
     ui->widget->scale = arg1;
     ui->rescaling->setValue(50);
-    ui->widget->update();
   }
 }
 
@@ -368,13 +478,12 @@ void MainWindow::on_rescaling_input_valueChanged(int arg1) {
  * @param value The new X-axis translation value.
  */
 void MainWindow::resTransX_valueChanged(int value) {
-  if (ui->widget->data_obj.vertex_array.matrix) {
+  if (ui->widget->data_obj.vertex_count) {
     double new_moveX = ui->widget->max_vertex_value * value / 100;
-    move_x(&ui->widget->data_obj, new_moveX, ui->widget->cur_moveX);
+    ui->widget->move_model(new_moveX - ui->widget->cur_moveX, 0, 0);
     ui->widget->moveX = value;
     ui->widget->cur_moveX = new_moveX;
     ui->resTransX_input->setValue(0);
-    ui->widget->update();
   }
 }
 
@@ -389,14 +498,13 @@ void MainWindow::resTransX_valueChanged(int value) {
  * @param arg1 The new X-axis translation input value.
  */
 void MainWindow::on_resTransX_input_valueChanged(double arg1) {
-  move_x(&ui->widget->data_obj, arg1, ui->widget->cur_moveX);
+  ui->widget->move_model(arg1 - ui->widget->cur_moveX, 0, 0);
   ui->resTransX_input->setMaximum(3 * ui->widget->max_vertex_value);
   ui->resTransX_input->setMinimum(-3 * ui->widget->max_vertex_value);
   ui->widget->cur_moveX = arg1;
   int value = arg1 * 100 / ui->widget->max_vertex_value;
   ui->widget->moveX = value;
   ui->resTransX->setValue(0);
-  ui->widget->update();
 }
 
 /**
@@ -409,13 +517,12 @@ void MainWindow::on_resTransX_input_valueChanged(double arg1) {
  * @param value The new Y-axis translation value.
  */
 void MainWindow::resTransY_valueChanged(int value) {
-  if (ui->widget->data_obj.vertex_array.matrix) {
+  if (ui->widget->data_obj.vertex_count) {
     double new_moveY = ui->widget->max_vertex_value * value / 100;
-    move_y(&ui->widget->data_obj, new_moveY, ui->widget->cur_moveY);
+    ui->widget->move_model(0, new_moveY - ui->widget->cur_moveY, 0);
     ui->widget->moveY = value;
     ui->widget->cur_moveY = new_moveY;
     ui->resTransY_input->setValue(0);
-    ui->widget->update();
   }
 }
 
@@ -428,14 +535,13 @@ void MainWindow::resTransY_valueChanged(int value) {
  * @param arg1 The new Y-axis translation input value.
  */
 void MainWindow::on_resTransY_input_valueChanged(double arg1) {
-  move_y(&ui->widget->data_obj, arg1, ui->widget->cur_moveY);
+  ui->widget->move_model(0, arg1 - ui->widget->cur_moveY, 0);
   ui->resTransY_input->setMaximum(3 * ui->widget->max_vertex_value);
   ui->resTransY_input->setMinimum(-3 * ui->widget->max_vertex_value);
   ui->widget->cur_moveY = arg1;
   int value = arg1 * 100 / ui->widget->max_vertex_value;
   ui->widget->moveY = value;
   ui->resTransY->setValue(0);
-  ui->widget->update();
 }
 
 /**
@@ -448,13 +554,12 @@ void MainWindow::on_resTransY_input_valueChanged(double arg1) {
  * @param value The new Z-axis translation value.
  */
 void MainWindow::resTransZ_valueChanged(int value) {
-  if (ui->widget->data_obj.vertex_array.matrix) {
+  if (ui->widget->data_obj.vertex_count) {
     double new_moveZ = ui->widget->max_vertex_value * value / 100;
-    move_z(&ui->widget->data_obj, new_moveZ, ui->widget->cur_moveZ);
+    ui->widget->move_model(0, 0, new_moveZ - ui->widget->cur_moveZ);
     ui->widget->moveZ = value;
     ui->widget->cur_moveZ = new_moveZ;
     ui->resTransZ_input->setValue(0);
-    ui->widget->update();
   }
 }
 
@@ -467,14 +572,13 @@ void MainWindow::resTransZ_valueChanged(int value) {
  * @param arg1 The new Z-axis translation input value.
  */
 void MainWindow::on_resTransZ_input_valueChanged(double arg1) {
-  move_z(&ui->widget->data_obj, arg1, ui->widget->cur_moveZ);
+  ui->widget->move_model(0, 0, arg1 - ui->widget->cur_moveZ);
   ui->resTransZ_input->setMaximum(3 * ui->widget->max_vertex_value);
   ui->resTransZ_input->setMinimum(-3 * ui->widget->max_vertex_value);
   ui->widget->cur_moveZ = arg1;
   int value = arg1 * 100 / ui->widget->max_vertex_value;
   ui->widget->moveZ = value;
   ui->resTransZ->setValue(0);
-  ui->widget->update();
 }
 
 /**
@@ -487,11 +591,10 @@ void MainWindow::on_resTransZ_input_valueChanged(double arg1) {
  * @param value The new X-axis rotation value.
  */
 void MainWindow::resRotateX_valueChanged(int value) {
-  if (value != 0 && ui->widget->data_obj.vertex_array.matrix) {
-    rotate_x(&ui->widget->data_obj, value, ui->widget->rotateX);
+  if (value != 0 && ui->widget->data_obj.vertex_count) {
+    ui->widget->rotate_model_x(value - ui->widget->rotateX);
     ui->widget->rotateX = value;
     ui->resRotateX_input->setValue(0);
-    ui->widget->update();
   }
 }
 
@@ -505,11 +608,10 @@ void MainWindow::resRotateX_valueChanged(int value) {
  * @param arg1 The new X-axis rotation input value.
  */
 void MainWindow::on_resRotateX_input_valueChanged(int arg1) {
-  if (ui->widget->data_obj.vertex_array.matrix) {
-    rotate_x(&ui->widget->data_obj, arg1, ui->widget->rotateX);
+  if (ui->widget->data_obj.vertex_count) {
+    ui->widget->rotate_model_x(arg1 - ui->widget->rotateX);
     ui->widget->rotateX = arg1;
     ui->resRotateX->setValue(0);
-    ui->widget->update();
   }
 }
 
@@ -523,11 +625,10 @@ void MainWindow::on_resRotateX_input_valueChanged(int arg1) {
  * @param value The new Y-axis rotation value.
  */
 void MainWindow::resRotateY_valueChanged(int value) {
-  if (value != 0 && ui->widget->data_obj.vertex_array.matrix) {
-    rotate_y(&ui->widget->data_obj, value, ui->widget->rotateY);
+  if (value != 0 && ui->widget->data_obj.vertex_count) {
+    ui->widget->rotate_model_y(value - ui->widget->rotateY);
     ui->widget->rotateY = value;
     ui->resRotateY_input->setValue(0);
-    ui->widget->update();
   }
 }
 
@@ -541,11 +642,10 @@ void MainWindow::resRotateY_valueChanged(int value) {
  * @param arg1 The new Y-axis rotation input value.
  */
 void MainWindow::on_resRotateY_input_valueChanged(int arg1) {
-  if (ui->widget->data_obj.vertex_array.matrix) {
-    rotate_y(&ui->widget->data_obj, arg1, ui->widget->rotateY);
+  if (ui->widget->data_obj.vertex_count) {
+    ui->widget->rotate_model_y(arg1 - ui->widget->rotateY);
     ui->widget->rotateY = arg1;
     ui->resRotateY->setValue(0);
-    ui->widget->update();
   }
 }
 
@@ -559,11 +659,10 @@ void MainWindow::on_resRotateY_input_valueChanged(int arg1) {
  * @param value The new Z-axis rotation value.
  */
 void MainWindow::resRotateZ_valueChanged(int value) {
-  if (value != 0 && ui->widget->data_obj.vertex_array.matrix) {
-    rotate_z(&ui->widget->data_obj, value, ui->widget->rotateZ);
+  if (value != 0 && ui->widget->data_obj.vertex_count) {
+    ui->widget->rotate_model_z(value - ui->widget->rotateZ);
     ui->widget->rotateZ = value;
     ui->resRotateZ_input->setValue(0);
-    ui->widget->update();
   }
 }
 
@@ -577,26 +676,22 @@ void MainWindow::resRotateZ_valueChanged(int value) {
  * @param arg1 The new Z-axis rotation input value.
  */
 void MainWindow::on_resRotateZ_input_valueChanged(int arg1) {
-  if (ui->widget->data_obj.vertex_array.matrix) {
-    rotate_z(&ui->widget->data_obj, arg1, ui->widget->rotateZ);
+  if (ui->widget->data_obj.vertex_count) {
+    ui->widget->rotate_model_z(arg1 - ui->widget->rotateZ);
     ui->widget->rotateZ = arg1;
     ui->resRotateZ->setValue(0);
-    ui->widget->update();
   }
 }
 
 /**
- * Resets all transformations when switching tabs in the tab widget.
- *
- * This function is triggered when the current tab changes in the tab widget.
- * It calls the resetAll_clicked() method to reset all transformations applied
- * to the 3D model when switching between tabs.
+ * Resets all transformations applied to the 3D model.
  *
- * @param index The index of the newly selected tab.
+ * Returns the controls to their defaults and the model matrix to the identity.
+ * The parsed vertices are never changed, so the file is not loaded again.
  */
 void MainWindow::resetAll_clicked() {
   reset();
-  MainWindow::run_clicked();
+  ui->widget->reset_model();
 }
 
 /**
@@ -734,11 +829,15 @@ void MainWindow::backgroungColor_clicked() {
  *
  * Grabs the current view of the 3D widget, opens a file dialog for the user to
  * choose a save location, and saves the screenshot in the selected format (BMP
- * or JPEG).
+ * or JPEG). With "CPU renderer" checked the image is made by soft_render()
+ * instead, which gives the same picture without reading back the GPU.
  */
 void MainWindow::screenshotButton_clicked() {
   QPixmap screen;
-  screen = ui->widget->grab();
+  if (ui->softRender->isChecked())
+    screen = QPixmap::fromImage(ui->widget->render_image(ui->widget->size()));
+  else
+    screen = ui->widget->grab();
   QString screen_path;
   if (ui->widget->format == 0) {
     screen_path = QFileDialog::getSaveFileName(this, tr("Save File"), "",
@@ -775,51 +874,75 @@ void MainWindow::jpegImage_clicked() {
 }
 
 /**
- * Starts capturing frames for GIF animation creation.
+ * Starts recording a GIF animation.
  *
- * When called, this function initializes the frame counter and starts a timer
- * to capture frames at regular intervals. The captured frames will later be
- * combined into a GIF animation.
+ * Asks for the file name first and opens it, then starts a timer that
+ * captures the frames at regular intervals. The frames are encoded and
+ * written by the background encoder while the capture goes on.
  *
  * @note The timer interval is set to 100ms, resulting in approximately 10
  * frames per second.
  */
 void MainWindow::gif_clicked() {
+  if (timer->isActive() || gif_encoder->isRunning()) return;
+  QString gif_path = QFileDialog::getSaveFileName(
+      this, tr("Save File"), "", tr("Gif-animation (*.gif)"));
+  if (gif_path.isEmpty()) return;
+  if (!gif_encoder->begin(gif_path, QSize(640, 480))) {
+    QMessageBox::information(this, "ERROR", "Cannot write " + gif_path);
+    return;
+  }
+  ui->gif->setEnabled(false);
+  ui->gifProgress->setRange(0, gif_frame_count);
+  ui->gifProgress->setValue(0);
+  ui->gifProgress->setVisible(true);
   count_frames = 0;
   timer->start(100);  // 100ms = 10 кадров в секунду
 }
 
 /**
- * Saves the captured frames as a GIF animation or continues frame capture.
+ * Captures one frame of the GIF animation.
  *
- * This function checks if the number of captured frames has reached the limit
- * (50). If not, it captures another frame and increments the counter. If the
- * limit is reached, it stops the timer, creates a GIF image, adds all captured
- * frames to it without delay, prompts the user to save the GIF file, and resets
- * the frame counter.
+ * The frame is only grabbed and queued here, so encoding never delays the
+ * next capture. After the last frame the timer is stopped and the encoder is
+ * told to finish the file.
  *
  * @note The GIF animation is saved with dimensions 640x480 pixels.
  */
 void MainWindow::save_gif() {
-  if (count_frames < 50) {  // 10 * 5 сек
-    frames[count_frames] =
-        ui->widget->grab()
-            .toImage();  // grab() функция QPixmap. toImage() конвертирует
-                         // QPixmap в QImage. Это нужно для addFrame()
-    count_frames++;
-  } else {
+  // grab() функция QPixmap. toImage() конвертирует QPixmap в QImage
+  gif_encoder->add_frame(ui->widget->grab().toImage(),
+                         0);  // кадры идут без задержки
+  if (++count_frames >= gif_frame_count) {
     timer->stop();
-    QGifImage gif(QSize(640, 480));
-    for (int i = 0; i < count_frames; i++) {
-      gif.addFrame(frames[i], 0);  // объединить фреймы в gif без задержки
-    }
-    QString gif_path = QFileDialog::getSaveFileName(
-        this, tr("Save File"), "", tr("Gif-animation (*.gif)"));
-    gif.save(gif_path);
-    count_frames = 0;
+    gif_encoder->finish();
   }
 }
 
+/**
+ * Shows how many captured frames have been encoded.
+ *
+ * @param written Number of frames written to the file.
+ * @param queued Number of frames captured so far.
+ */
+void MainWindow::gif_progress(int written, int queued) {
+  Q_UNUSED(queued);
+  ui->gifProgress->setValue(written);
+}
+
+/**
+ * Restores the controls once the GIF file has been written.
+ *
+ * @note If a frame could not be written, an error message is displayed.
+ */
+void MainWindow::gif_finished() {
+  ui->gifProgress->setVisible(false);
+  ui->gif->setEnabled(true);
+  if (!gif_encoder->ok())
+    QMessageBox::information(this, "ERROR",
+                             "Cannot write " + gif_encoder->file());
+}
+
 /**
  * Handles mouse press events for the main window.
  *
@@ -853,27 +976,43 @@ void MainWindow::mouseReleaseEvent(QMouseEvent* event) {
  * Handles mouse movement events for the main window.
  *
  * This function processes mouse movements while the left mouse button is
- * pressed. It calculates the change in mouse position, updates rotation angles,
- * and triggers rotation changes for the 3D viewer.
+ * pressed. The change in mouse position is only accumulated here; the
+ * rotation is applied by apply_input() once per display frame, however many
+ * events arrive in between.
  *
  * @param event Pointer to the QMouseEvent containing information about the
  * mouse move event.
  */
 void MainWindow::mouseMoveEvent(QMouseEvent* event) {
-  static float angleX = 0;
-  static float angleY = 0;
   static float sensitivity = 0.5f;
 
   if (LeftMousePressed) {
     QPoint curPos = event->pos();
 
-    float dx = (curPos.x() - lastPos.x()) * sensitivity;
-    float dy = (curPos.y() - lastPos.y()) * sensitivity;
-    angleX += dy;
-    angleY -= dx;
+    pending_rotate_x += (curPos.y() - lastPos.y()) * sensitivity;
+    pending_rotate_y -= (curPos.x() - lastPos.x()) * sensitivity;
+    ui->widget->counters.input++;
+    if (!input_timer->isActive()) input_timer->start();
+    this->lastPos = curPos;
+  }
+}
+
+/**
+ * Applies the mouse rotation accumulated since the last display frame.
+ *
+ * Rotating back and forth within one frame leaves the model matrix as it
+ * was, and then no frame is drawn at all.
+ */
+void MainWindow::apply_input() {
+  static float angleX = 0;
+  static float angleY = 0;
+
+  if (pending_rotate_x != 0 || pending_rotate_y != 0) {
+    angleX += pending_rotate_x;
+    angleY += pending_rotate_y;
+    pending_rotate_x = pending_rotate_y = 0;
     resRotateX_valueChanged(angleX);
     resRotateY_valueChanged(angleY);
-    this->lastPos = curPos;
   }
 }
 
@@ -906,6 +1045,8 @@ void MainWindow::wheelEvent(QWheelEvent* event) {
  * Y axes. It responds to W, S, D, and A keys, adjusting the model's position
  * accordingly. The translation values are bounded within specified limits and
  * trigger corresponding value changed events.
+ * F3 shows or hides the statistics overlay, F4 saves the recorded frame
+ * statistics as CSV.
  *
  * @param event Pointer to the QKeyEvent containing information about the key
  * press event.
@@ -928,6 +1069,14 @@ void MainWindow ::keyPressEvent(QKeyEvent* event) {
   } else if (key == Qt::Key_A) {
     value = ui->widget->moveX - step;
     resTransX_valueChanged(qBound(minBorder, value, maxBorder));
+  } else if (key == Qt::Key_F3) {
+    ui->widget->show_stats = !ui->widget->show_stats;
+    ui->widget->update();
+  } else if (key == Qt::Key_F4) {
+    QString stats_path = QFileDialog::getSaveFileName(
+        this, tr("Save statistics"), "", tr("CSV files (*.csv)"));
+    if (!stats_path.isEmpty() && !ui->widget->save_stats(stats_path))
+      QMessageBox::information(this, "ERROR", "Cannot write the statistics");
   }
   event->accept();
 }
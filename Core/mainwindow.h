@@ -30,7 +30,8 @@
 #include <QVector>
 #include <QWidget>
 
-#include "QtGifImage/src/gifimage/qgifimage.h"
+#include "gifencoder.h"
+#include "modelloader.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -51,6 +52,10 @@ class MainWindow : public QMainWindow {
   void reset();
   void openFile_clicked();
   void run_clicked();
+  void cancelLoad_clicked();
+  void load_progress(qint64 done, qint64 total);
+  void load_finished();
+  void show_frame_time(double cpu_msec, double gpu_msec);
   void central_clicked();
   void parallel_clicked();
   void rescaling_valueChanged(int value);
@@ -84,12 +89,16 @@ class MainWindow : public QMainWindow {
   void jpegImage_clicked();
   void gif_clicked();
   void save_gif();
+  void gif_progress(int written, int queued);
+  void gif_finished();
+  void apply_input();
 
  public:
-  double max_vertex;
   void save_settings();
   void load_settings();
-  void get_max_vertex();
+  void show_open_time(const QString& file, bool from_cache, double msec);
+  void show_memory();
+  void set_loading(bool loading);
 
   //
   QPoint lastPos;  // Последняя позиция курсора мыши
@@ -106,7 +115,14 @@ class MainWindow : public QMainWindow {
   Ui::MainWindow* ui;
   QSettings* settings;
   QTimer* timer;
+  QTimer* input_timer;  // Применяет накопленный ввод раз в кадр
+  float pending_rotate_x = 0;
+  float pending_rotate_y = 0;
+  ModelLoader* loader;
   int count_frames;
-  QImage frames[50];
+  QString timed_file;
+  double cold_open_ms = -1;
+  double warm_open_ms = -1;
+  GifEncoder* gif_encoder;  // Кодирует кадры GIF в фоновом потоке
 };
 #endif  // MAINWINDOW_H
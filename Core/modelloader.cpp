@@ -0,0 +1,137 @@
+/**
+ * @class ModelLoader
+ * @brief Loads .obj files on a worker thread
+ *
+ * The loader runs load_obj() outside the GUI thread and reports how many
+ * bytes of the file have been parsed. A running load can be canceled; the
+ * parser then stops at its next progress report and the displayed model is
+ * left untouched.
+ *
+ * Usage:
+ * - Connect progress() to a progress bar and finished() to a slot
+ * - Call load() to start loading a file
+ * - In the finished() slot call take() unless canceled() or status() failed
+ */
+
+#include "modelloader.h"
+
+#include <QElapsedTimer>
+#include <utility>
+
+/**
+ * @brief Constructor
+ * @param parent Parent object
+ */
+ModelLoader::ModelLoader(QObject *parent) : QThread{parent} {}
+
+/**
+ * @brief Destructor
+ * Stops a running load and frees the model held by the loader
+ */
+ModelLoader::~ModelLoader() {
+  cancel();
+  wait();
+  memory_free(&data_obj);
+}
+
+/**
+ * @brief Starts loading a file on the worker thread
+ * @param file_name Name of the .obj file
+ * @param quantize Whether to store the vertices as 16-bit integers
+ */
+void ModelLoader::load(const QString &file_name, bool quantize) {
+  if (isRunning()) return;
+  this->file_name = file_name;
+  this->quantize = quantize;
+  file_name_utf8 = file_name.toUtf8();
+  cancel_requested = false;
+  result = ERROR;
+  cached = 0;
+  start();
+}
+
+/**
+ * @brief Asks a running load to stop
+ */
+void ModelLoader::cancel() { cancel_requested = true; }
+
+/**
+ * @brief Tells whether the last load was canceled
+ */
+bool ModelLoader::canceled() const { return cancel_requested; }
+
+/**
+ * @brief Returns the status of the last load, OK or ERROR
+ */
+int ModelLoader::status() const { return result; }
+
+/**
+ * @brief Tells whether the last model came from the binary cache
+ */
+bool ModelLoader::from_cache() const { return cached; }
+
+/**
+ * @brief Returns the duration of the last load in milliseconds
+ */
+double ModelLoader::elapsed_ms() const { return msec; }
+
+/**
+ * @brief Returns the duration of the stages of the last load
+ */
+load_times ModelLoader::times() const { return stages; }
+
+/**
+ * @brief Returns the name of the last loaded file
+ */
+QString ModelLoader::file() const { return file_name; }
+
+/**
+ * @brief Swaps the loaded model with the given one
+ *
+ * Must only be called when the thread is not running. The model that was
+ * swapped out is emptied but keeps its memory for the next load.
+ *
+ * @param target Model to replace
+ */
+void ModelLoader::take(data_object *target) {
+  std::swap(*target, data_obj);
+  memory_reset(&data_obj);
+}
+
+/**
+ * @brief Loads the file, called on the worker thread
+ */
+void ModelLoader::run() {
+  parser_options options = {};
+  options.progress = report_progress;
+  options.progress_context = this;
+  QElapsedTimer timer;
+  timer.start();
+  stages = load_times();
+  auto lap = [&timer]() { return timer.nsecsElapsed() / 1e6; };
+  result = load_obj(file_name_utf8.data(), &data_obj, &options, &cached);
+  stages.load = lap();
+  if (result == OK && quantize) {
+    result = quantize_object(&data_obj);
+    stages.quantize = lap() - stages.load;
+  }
+  if (result == OK) {
+    double start = lap();
+    result = build_edges(&data_obj);
+    stages.edges = lap() - start;
+  }
+  msec = lap();
+}
+
+/**
+ * @brief Forwards parser progress, called from parser threads
+ * @param context The loader
+ * @param done Number of bytes parsed
+ * @param total Size of the file, 0 if unknown
+ * @return Non-zero to cancel the parse
+ */
+int ModelLoader::report_progress(void *context, size_t done, size_t total) {
+  ModelLoader *loader = static_cast<ModelLoader *>(context);
+  emit loader->progress(static_cast<qint64>(done), static_cast<qint64>(total));
+  return loader->cancel_requested ? 1 : 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file modelloader.h
+ * @brief Header file for the background model loader
+ *
+ * This header file declares the ModelLoader class, which loads .obj files on
+ * a worker thread so that the main window stays responsive while large
+ * models are parsed.
+ */
+
+#ifndef MODELLOADER_H
+#define MODELLOADER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QThread>
+#include <atomic>
+
+extern "C" {
+#include "3DViever.h"
+}
+
+/**
+ * @struct load_times
+ * @brief Duration of the stages of a load in milliseconds
+ *
+ * load is the time of load_obj(): parsing, which includes the bounding box,
+ * or reading the binary cache. quantize is zero unless 16-bit vertices were
+ * requested.
+ */
+struct load_times {
+  double load = 0;
+  double quantize = 0;
+  double edges = 0;
+};
+
+/**
+ * @class ModelLoader
+ * @brief Worker thread that loads one model at a time
+ *
+ * The model is loaded into a data_object owned by the loader. Once the
+ * thread has finished, take() swaps it with the displayed one, so the widget
+ * never sees a half-loaded model. The previous model stays in the loader and
+ * its memory is reused by the next load.
+ */
+class ModelLoader : public QThread {
+  Q_OBJECT
+ public:
+  explicit ModelLoader(QObject *parent = nullptr);
+  ~ModelLoader() override;
+
+  void load(const QString &file_name, bool quantize = false);
+  void cancel();
+  bool canceled() const;
+  int status() const;
+  bool from_cache() const;
+  double elapsed_ms() const;
+  load_times times() const;
+  QString file() const;
+  void take(data_object *target);
+
+ signals:
+  void progress(qint64 done, qint64 total);
+
+ protected:
+  void run() override;
+
+ private:
+  static int report_progress(void *context, size_t done, size_t total);
+
+  QString file_name;
+  QByteArray file_name_utf8;
+  data_object data_obj = {};
+  std::atomic<bool> cancel_requested{false};
+  int result = ERROR;
+  int cached = 0;
+  bool quantize = false;
+  double msec = 0;
+  load_times stages;
+};
+
+#endif  // MODELLOADER_H
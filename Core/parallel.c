@@ -0,0 +1,84 @@
+/**
+ * @file parallel.c
+ * @brief Minimal worker pool for splitting work across CPU cores
+ *
+ * This module runs a set of independent tasks on a group of POSIX threads.
+ * Workers pull task numbers from a shared atomic counter, so uneven tasks are
+ * balanced automatically, and the calling thread takes part in the work.
+ *
+ * Key features:
+ * - Detects the number of online CPU cores
+ * - Runs tasks in the calling thread when only one worker is requested
+ * - Returns only when every task has finished
+ */
+
+#include "3DViever.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+/**
+ * @struct parallel_job
+ * @brief Work shared by all threads of one parallel_for() call
+ */
+typedef struct parallel_job {
+  void (*task)(void *context, size_t index);
+  void *context;
+  size_t tasks;
+  atomic_size_t next;
+} parallel_job;
+
+/**
+ * @brief Returns the number of online CPU cores
+ *
+ * @return Number of cores, at least 1
+ */
+int parallel_threads(void) {
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  return cores > 0 ? (int)cores : 1;
+}
+
+/**
+ * @brief Runs tasks until the shared counter is exhausted
+ *
+ * @param arg Pointer to the parallel_job
+ * @return NULL
+ */
+static void *parallel_worker(void *arg) {
+  parallel_job *job = arg;
+  size_t index;
+  while ((index = atomic_fetch_add(&job->next, 1)) < job->tasks)
+    job->task(job->context, index);
+  return NULL;
+}
+
+/**
+ * @brief Runs task(context, i) for every i in [0, tasks)
+ *
+ * The tasks are spread over at most threads threads, including the calling
+ * one. If a thread cannot be created its share of the work is done by the
+ * remaining threads.
+ *
+ * @param tasks Number of tasks
+ * @param threads Number of threads, 0 for one per CPU core
+ * @param task Function called for every task
+ * @param context Pointer passed to every call of task
+ */
+void parallel_for(size_t tasks, int threads,
+                  void (*task)(void *context, size_t index), void *context) {
+  parallel_job job = {task, context, tasks, 0};
+  if (threads <= 0) threads = parallel_threads();
+  if ((size_t)threads > tasks) threads = (int)tasks;
+  pthread_t *workers =
+      threads > 1 ? calloc(threads - 1, sizeof(pthread_t)) : NULL;
+  int started = 0;
+  if (workers) {
+    while (started < threads - 1 &&
+           pthread_create(&workers[started], NULL, parallel_worker, &job) == 0)
+      started++;
+  }
+  parallel_worker(&job);
+  for (int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+  free(workers);
+}
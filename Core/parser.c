@@ -3,17 +3,19 @@
  * @brief Module for parsing 3D model files (.obj)
  *
  * This module contains functions for parsing .obj files and creating data
- * structures to represent 3D models. It includes functions for counting
- * vertices and polygons, parsing vertex coordinates, and creating matrices and
- * polygons.
+ * structures to represent 3D models. The file is read once: vertices and
+ * polygons are appended to growable buffers as their lines are met. The
+ * indices of all polygons share one array, and the finished model is copied
+ * into a single allocation from the arena of the data_object.
  *
  * Key features:
  * - Parses .obj files to extract 3D model information
- * - Counts vertices and polygons in the input file
+ * - Reads the input file in a single pass
  * - Stores parsed vertex coordinates in a matrix
- * - Creates polygon arrays based on edge counts
- * - Allocates memory for matrices and polygons as needed
+ * - Stores polygons as one index array plus an array of offsets
+ * - Grows buffers geometrically instead of counting lines beforehand
  * - Provides functions for freeing allocated memory when done
+ * - Reuses the memory of the previous model on reload
  *
  * Usage:
  *   1. Initialize a data_object structure
@@ -23,121 +25,620 @@
 
 #include "3DViever.h"
 
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// Size of the mapped window released after it has been parsed
+#define MAP_WINDOW ((size_t)4 << 20)
+/// Smallest part of a mapped file given to a parser thread
+#define CHUNK_MIN ((size_t)1 << 20)
+/// Number of bytes parsed between two progress reports
+#define PROGRESS_STEP ((size_t)1 << 20)
+
 /**
- * @brief Parses vertex coordinates from an .obj file
+ * @struct progress_state
+ * @brief Progress of one parse_obj() call, shared by all parser threads
+ */
+typedef struct progress_state {
+  int (*callback)(void *context, size_t done, size_t total);
+  void *context;
+  size_t total;
+  atomic_size_t done;
+  atomic_int canceled;
+} progress_state;
+
+/**
+ * @struct parse_state
+ * @brief Growable buffers filled while the file is read
  *
- * Reads vertex coordinates from the file and stores them in the vertex_array
- * of the data_object struct.
+ * Vertices and polygons are appended as their lines are met, so the file is
+ * read exactly once. Row 0 of the vertex buffer is kept zeroed because face
+ * indices in .obj files are 1-based. offsets[i] is the position of the first
+ * index of polygon i, and offsets[polygon_count] equals index_count.
  *
- * @param file Pointer to the .obj file
- * @param data_obj Pointer to the data_object struct
+ * A chunk of a file parsed in parallel resolves negative indices against its
+ * own vertices only. When track_relative is set, the positions of these
+ * indices are kept in relative so that they can be shifted by the number of
+ * vertices of the preceding chunks when the chunks are merged.
+ *
+ * min, max and sum accumulate the bounding box and the coordinate sums of the
+ * vertices read so far, so the model needs no extra pass over its vertices.
+ */
+typedef struct parse_state {
+  double *vertices;
+  size_t vertex_count;
+  size_t vertex_capacity;
+  unsigned int *indices;
+  size_t index_count;
+  size_t index_capacity;
+  size_t *offsets;
+  size_t polygon_count;
+  size_t offset_capacity;
+  int track_relative;
+  size_t *relative;
+  size_t relative_count;
+  size_t relative_capacity;
+  double min[3];
+  double max[3];
+  double sum[3];
+  progress_state *progress;
+} parse_state;
+
+/**
+ * @struct chunk_job
+ * @brief Mapped file split at line boundaries for parallel parsing
+ *
+ * Chunk i spans bounds[i] to bounds[i + 1] and is parsed into states[i].
+ */
+typedef struct chunk_job {
+  const char *data;
+  const char **bounds;
+  parse_state *states;
+  int *status;
+  progress_state *progress;
+} chunk_job;
+
+/**
+ * @brief Grows a buffer geometrically so that it holds at least need items
+ *
+ * @param buffer Address of the buffer pointer, updated on success
+ * @param capacity Address of the current capacity in items
+ * @param need Required number of items
+ * @param item_size Size of one item in bytes
  * @return OK if successful, ERROR otherwise
  */
-int parser_vert_pol(FILE *file, data_object *data_obj) {
+static int reserve(void **buffer, size_t *capacity, size_t need,
+                   size_t item_size) {
   int status = OK;
-  char *buff = NULL;
-  size_t len = 0, count = 1;
-  double x = 0, y = 0, z = 0;
-  long tmp;
-  char *istr;
-  char str[1025] = "";
-  int i = 3, j = 0, m = 0;
-  if (!data_obj && !data_obj->polygon_array) status = ERROR;
-  while ((getline(&buff, &len, file)) != -1) {
-    if ((buff[0] == 'v') && (buff[1] == ' ')) {
-      if (sscanf(buff, "v %lf %lf %lf", &x, &y, &z) == 3) {
-        count++;
-        data_obj->vertex_array.matrix[i++] = x;
-        data_obj->vertex_array.matrix[i++] = y;
-        data_obj->vertex_array.matrix[i++] = z;
-      } else
-        status = ERROR;
-    } else if ((buff[0] == 'f') &&
-               (buff[1] == ' ')) {  // записываем в массив координаты ребер
-      strcpy(str, buff);
-      istr = strtok(buff + 1, " ");  // Выделение первой части строки
-      while (istr != NULL && atoi(istr) != 0) {  // Выделение последующих частей
-        data_obj->edges_count++;
-        istr = strtok(NULL, " ");  // Выделение очередной части строки
-      }
-      if (create_polygon(data_obj->edges_count, &data_obj->polygon_array[m]) ==
-          OK) {
-        istr = strtok(str + 1, " ");
-        while (istr != NULL) {  // Выделение последующих частей
-          data_obj->all_edges_count++;
-          tmp = atoi(istr);
-          if (data_obj->polygon_array && data_obj->polygon_array[m].polygon) {
-            if (tmp < 0) {
-              data_obj->polygon_array[m].polygon[j++] = count + tmp;
-            } else {
-              data_obj->polygon_array[m].polygon[j++] = atoi(istr);
-            }
-          }
-          istr = strtok(NULL, " ");  // Выделение очередной части строки
-        }
-        data_obj->edges_count = 0;
-        m++;
+  if (need > *capacity) {
+    size_t new_capacity = *capacity ? *capacity * 2 : 64;
+    while (new_capacity < need) new_capacity *= 2;
+    void *tmp = realloc(*buffer, new_capacity * item_size);
+    if (tmp) {
+      *buffer = tmp;
+      *capacity = new_capacity;
+    } else
+      status = ERROR;
+  }
+  return status;
+}
+
+/**
+ * @brief Prepares an empty parser state
+ *
+ * @param state Parser state
+ * @param track_relative Non-zero to remember where relative indices were used
+ * @return OK if successful, ERROR otherwise
+ */
+static int state_init(parse_state *state, int track_relative) {
+  memset(state, 0, sizeof(parse_state));
+  state->track_relative = track_relative;
+  for (int i = 0; i < 3; i++) {
+    state->min[i] = HUGE_VAL;
+    state->max[i] = -HUGE_VAL;
+  }
+  // строка 0 остаётся нулевой: индексы в .obj начинаются с 1
+  int status = reserve((void **)&state->vertices, &state->vertex_capacity, 3,
+                       sizeof(double));
+  if (status == OK) memset(state->vertices, 0, 3 * sizeof(double));
+  if (status == OK)
+    status = reserve((void **)&state->offsets, &state->offset_capacity, 1,
+                     sizeof(size_t));
+  if (status == OK) state->offsets[0] = 0;
+  return status;
+}
+
+/**
+ * @brief Frees the buffers of a parser state that failed
+ *
+ * @param state Parser state
+ */
+static void state_free(parse_state *state) {
+  free(state->vertices);
+  free(state->indices);
+  free(state->offsets);
+  free(state->relative);
+  memset(state, 0, sizeof(parse_state));
+}
+
+/**
+ * @brief Appends the vertex described by a "v" line
+ *
+ * @param line Line starting with "v "
+ * @param end End of the line
+ * @param state Parser state
+ * @return OK if successful, ERROR otherwise
+ */
+static int parse_vertex(const char *line, const char *end,
+                        parse_state *state) {
+  int status = OK;
+  double xyz[3] = {0, 0, 0};
+  const char *pos = line + 1;
+  for (int i = 0; status == OK && i < 3; i++)
+    status = scan_double(&pos, end, &xyz[i]);
+  if (status == OK &&
+      reserve((void **)&state->vertices, &state->vertex_capacity,
+              (state->vertex_count + 2) * 3, sizeof(double)) != OK)
+    status = ERROR;
+  if (status == OK) {
+    state->vertex_count++;
+    memcpy(state->vertices + state->vertex_count * 3, xyz, sizeof(xyz));
+    for (int i = 0; i < 3; i++) {
+      if (xyz[i] < state->min[i]) state->min[i] = xyz[i];
+      if (xyz[i] > state->max[i]) state->max[i] = xyz[i];
+      state->sum[i] += xyz[i];
+    }
+  }
+  return status;
+}
+
+/**
+ * @brief Appends the polygon described by an "f" line
+ *
+ * Reads vertex indices until the first token that is not a number. Only the
+ * vertex part of "v/vt/vn" triplets is kept. Negative indices are relative to
+ * the vertices read so far.
+ *
+ * @param line Line starting with "f "
+ * @param end End of the line
+ * @param state Parser state
+ * @return OK if successful, ERROR otherwise
+ */
+static int parse_face(const char *line, const char *end, parse_state *state) {
+  int status = OK;
+  size_t count = 0;
+  const char *pos = line + 1;
+  long index = 0;
+  while (status == OK &&
+         scan_face_vertex(&pos, end, &index, NULL, NULL) == OK && index != 0) {
+    size_t at = state->index_count + count;
+    if (index < 0) {
+      index += (long)state->vertex_count + 1;
+      if (state->track_relative) {
+        if (reserve((void **)&state->relative, &state->relative_capacity,
+                    state->relative_count + 1, sizeof(size_t)) == OK)
+          state->relative[state->relative_count++] = at;
+        else
+          status = ERROR;
       }
     }
-    j = 0;
+    if (status == OK &&
+        reserve((void **)&state->indices, &state->index_capacity, at + 1,
+                sizeof(unsigned int)) == OK) {
+      state->indices[at] = (unsigned int)index;
+      count++;
+    } else
+      status = ERROR;
+  }
+  if (status == OK && count > 0) {
+    if (reserve((void **)&state->offsets, &state->offset_capacity,
+                state->polygon_count + 2, sizeof(size_t)) == OK) {
+      state->index_count += count;
+      state->offsets[++state->polygon_count] = state->index_count;
+    } else
+      status = ERROR;
+  }
+  return status;
+}
+
+/**
+ * @brief Parses one line of an .obj file
+ *
+ * @param line Start of the line
+ * @param end End of the line, excluding the line break
+ * @param state Parser state
+ * @return OK if successful, ERROR otherwise
+ */
+static int parse_line(const char *line, const char *end, parse_state *state) {
+  int status = OK;
+  if (end - line > 1 && line[1] == ' ') {
+    if (line[0] == 'v')
+      status = parse_vertex(line, end, state);
+    else if (line[0] == 'f')
+      status = parse_face(line, end, state);
   }
-  if (buff) free(buff);
   return status;
 }
 
 /**
- * @brief Counts vertices and polygons in an .obj file
+ * @brief Adds parsed bytes to the progress and calls the progress callback
  *
- * Reads through the file once to count the number of vertices and polygons.
+ * @param progress Shared progress, NULL if progress is not reported
+ * @param bytes Number of bytes parsed since the last report
+ * @return OK to go on, ERROR if the parse was canceled
+ */
+static int report_progress(progress_state *progress, size_t bytes) {
+  int status = OK;
+  if (progress) {
+    size_t done = atomic_fetch_add(&progress->done, bytes) + bytes;
+    if (!atomic_load(&progress->canceled) &&
+        progress->callback(progress->context, done, progress->total) != 0)
+      atomic_store(&progress->canceled, 1);
+    if (atomic_load(&progress->canceled)) status = ERROR;
+  }
+  return status;
+}
+
+/**
+ * @brief Parses an .obj file with buffered reads
+ *
+ * Used for pipes, stdin and other streams that cannot be mapped.
  *
  * @param file Pointer to the .obj file
- * @param data_obj Pointer to the data_object struct
+ * @param state Parser state
+ * @return OK if successful, ERROR otherwise
  */
-void count_vert_pol(FILE *file, data_object *data_obj) {
+static int parse_stream(FILE *file, parse_state *state) {
+  int status = OK;
   char *buff = NULL;
-  size_t len = 0;
-  while ((getline(&buff, &len, file)) != EOF) {
-    if ((buff[0] == 'v') && (buff[1] == ' '))
-      data_obj->vertex_count++;
-    else if ((buff[0] == 'f') && (buff[1] == ' ')) {
-      data_obj->polygon_count++;  // далее будем считать количество ребер
+  size_t len = 0, pending = 0;
+  ssize_t read = 0;
+  while (status == OK && (read = getline(&buff, &len, file)) != -1) {
+    status = parse_line(buff, buff + read, state);
+    pending += read;
+    if (status == OK && state->progress && pending >= PROGRESS_STEP) {
+      status = report_progress(state->progress, pending);
+      pending = 0;
     }
   }
+  if (status == OK && pending > 0)
+    status = report_progress(state->progress, pending);
   if (buff) free(buff);
+  return status;
 }
 
 /**
- * @brief Main function for parsing an .obj file
+ * @brief Parses a part of an .obj file mapped into memory
  *
- * Initializes the data_object struct, counts vertices and polygons, then parses
- * the vertex coordinates.
+ * Lines are tokenized straight from the mapped bytes. Whole MAP_WINDOW blocks
+ * of the part are dropped once they have been parsed to keep the resident
+ * size bounded. Progress is reported every PROGRESS_STEP bytes.
  *
- * @param file_name Name of the .obj file to parse
- * @param data_obj Pointer to the data_object struct
+ * @param data Start of the mapping
+ * @param begin Start of the part, at the beginning of a line
+ * @param end End of the part
+ * @param state Parser state
  * @return OK if successful, ERROR otherwise
  */
-int parser(char *file_name, data_object *data_obj) {
-  if (file_name == NULL || data_obj == NULL) return ERROR;
-  FILE *file = fopen(file_name, "r");
+static int parse_mapped(const char *data, const char *begin, const char *end,
+                        parse_state *state) {
   int status = OK;
-  if (file) {
-    count_vert_pol(file, data_obj);
-    if (data_obj->polygon_count > 0) {
-      data_obj->polygon_array =
-          (polygon_t *)calloc(data_obj->polygon_count, sizeof(polygon_t));
+  const char *pos = begin;
+  const char *reported = begin;
+  size_t released =
+      ((size_t)(begin - data) + MAP_WINDOW - 1) & ~(MAP_WINDOW - 1);
+  while (status == OK && pos < end) {
+    const char *eol = memchr(pos, '\n', end - pos);
+    if (!eol) eol = end;
+    status = parse_line(pos, eol, state);
+    pos = eol < end ? eol + 1 : end;
+    size_t done = (size_t)(pos - data) & ~(MAP_WINDOW - 1);
+    if (done > released) {
+      madvise((char *)data + released, done - released, MADV_DONTNEED);
+      released = done;
+    }
+    if (status == OK && state->progress &&
+        (size_t)(pos - reported) >= PROGRESS_STEP) {
+      status = report_progress(state->progress, pos - reported);
+      reported = pos;
     }
-    if (create_matrix(data_obj->vertex_count + 1, (size_t)3,
-                      &data_obj->vertex_array) == OK) {
-      fseek(file, 0, SEEK_SET);  // возврат к началу файла
-      status = parser_vert_pol(file, data_obj);
+  }
+  if (status == OK && pos > reported)
+    status = report_progress(state->progress, pos - reported);
+  return status;
+}
+
+/**
+ * @brief Parses one chunk of a mapped file, called by parallel_for()
+ *
+ * Only chunks after the first one need to remember their relative indices.
+ *
+ * @param context Pointer to the chunk_job
+ * @param index Number of the chunk
+ */
+static void parse_chunk(void *context, size_t index) {
+  chunk_job *job = context;
+  job->status[index] = state_init(&job->states[index], index > 0);
+  job->states[index].progress = job->progress;
+  if (job->status[index] == OK)
+    job->status[index] =
+        parse_mapped(job->data, job->bounds[index], job->bounds[index + 1],
+                     &job->states[index]);
+}
+
+/**
+ * @brief Frees an array of parser states
+ *
+ * @param states Parser states, may be NULL
+ * @param count Number of states
+ */
+static void states_free(parse_state *states, size_t count) {
+  for (size_t i = 0; states && i < count; i++) state_free(&states[i]);
+  free(states);
+}
+
+/**
+ * @brief Parses a mapped file, splitting it across threads when it is large
+ *
+ * The file is cut into chunks of at least CHUNK_MIN bytes at line boundaries
+ * and every chunk is parsed into its own state. Small files and files parsed
+ * with a single thread give a single state.
+ *
+ * @param data Mapped file
+ * @param size Size of the file in bytes
+ * @param threads Number of threads, 0 for one per CPU core
+ * @param progress Shared progress, NULL if progress is not reported
+ * @param states Address of the array of states in file order, allocated here
+ * @param count Number of states
+ * @return OK if successful, ERROR otherwise
+ */
+static int parse_mapped_parallel(const char *data, size_t size, int threads,
+                                 progress_state *progress,
+                                 parse_state **states, size_t *count) {
+  if (threads <= 0) threads = parallel_threads();
+  size_t chunks = (size_t)threads * 2;
+  if (chunks > size / CHUNK_MIN) chunks = size / CHUNK_MIN;
+  if (threads == 1 || chunks < 2) chunks = 1;
+  const char **bounds = calloc(chunks + 1, sizeof(char *));
+  int *status = calloc(chunks, sizeof(int));
+  *states = calloc(chunks, sizeof(parse_state));
+  *count = 0;
+  int result = bounds && status && *states ? OK : ERROR;
+  if (result == OK) {
+    size_t parts = 0;
+    const char *pos = data, *data_end = data + size;
+    while (pos < data_end) {
+      bounds[parts++] = pos;
+      const char *cut = data + size / chunks * parts;
+      if (cut < pos) cut = pos;
+      const char *eol =
+          parts < chunks ? memchr(cut, '\n', data_end - cut) : NULL;
+      pos = eol ? eol + 1 : data_end;
+    }
+    bounds[parts] = data_end;
+    chunk_job job = {data, bounds, *states, status, progress};
+    parallel_for(parts, threads, parse_chunk, &job);
+    *count = parts;
+    for (size_t i = 0; i < parts; i++)
+      if (status[i] != OK) result = ERROR;
+  }
+  free(bounds);
+  free(status);
+  return result;
+}
+
+/**
+ * @brief Reads an .obj file into parser states
+ *
+ * Regular files are mapped into memory unless buffered reads are requested;
+ * anything else, including stdin given as "-", is read with getline(). The
+ * total passed to the progress callback is 0 when the size is not known.
+ *
+ * @param file_name Name of the .obj file, "-" for stdin
+ * @param options Parser options
+ * @param states Address of the array of states in file order, allocated here
+ * @param count Number of states
+ * @return OK if successful, ERROR otherwise
+ */
+static int parse_file(const char *file_name, const parser_options *options,
+                      parse_state **states, size_t *count) {
+  int status = OK;
+  int mode = options->read_mode;
+  int use_stdin = strcmp(file_name, "-") == 0;
+  int fd = use_stdin ? STDIN_FILENO : open(file_name, O_RDONLY);
+  struct stat st;
+  progress_state progress = {.callback = options->progress,
+                             .context = options->progress_context};
+  atomic_init(&progress.done, 0);
+  atomic_init(&progress.canceled, 0);
+  progress_state *shared = options->progress ? &progress : NULL;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    status = ERROR;
+  } else if (mode != READ_BUFFERED && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    progress.total = st.st_size;
+    if (data != MAP_FAILED) {
+      madvise(data, st.st_size, MADV_SEQUENTIAL);
+      status = parse_mapped_parallel(data, st.st_size, options->threads,
+                                     shared, states, count);
+      munmap(data, st.st_size);
     } else
       status = ERROR;
-    fclose(file);
-  } else
+  } else if (mode == READ_MMAP && !S_ISREG(st.st_mode)) {
     status = ERROR;
+  } else {
+    FILE *file = use_stdin ? stdin : fdopen(fd, "r");
+    *states = calloc(1, sizeof(parse_state));
+    *count = *states ? 1 : 0;
+    if (S_ISREG(st.st_mode)) progress.total = st.st_size;
+    if (file && *states && state_init(*states, 0) == OK) {
+      (*states)->progress = shared;
+      status = parse_stream(file, *states);
+    } else
+      status = ERROR;
+    if (file && !use_stdin) {
+      fclose(file);
+      fd = -1;
+    }
+  }
+  if (fd >= 0 && !use_stdin) close(fd);
+  return status;
+}
+
+/**
+ * @brief Checks that every polygon refers to an existing vertex
+ *
+ * @param state Parser state with its relative indices already resolved
+ * @param vertex_count Number of vertices of the whole file
+ * @return OK if all indices are in range, ERROR otherwise
+ */
+static int check_indices(const parse_state *state, size_t vertex_count) {
+  int status = OK;
+  for (size_t i = 0; status == OK && i < state->index_count; i++) {
+    unsigned int index = state->indices[i];
+    if (index == 0 || index > vertex_count) status = ERROR;
+  }
+  return status;
+}
+
+/**
+ * @brief Copies the parsed states into the arena of the data_object
+ *
+ * Relative indices of every state are first shifted by the number of vertices
+ * of the states before it, which gives the same result as parsing the file
+ * serially. The model is copied only after all indices have been checked, so
+ * a file that fails to parse leaves the previous model untouched. All arrays
+ * of the model share a single arena allocation. The bounding boxes and sums
+ * of the states are merged into the bounding box and centroid of the model.
+ *
+ * Every buffer of a state is freed as soon as it has been copied. The pages
+ * of a fresh arena block become resident only when they are written, so the
+ * parsed model and its copy are never both held in memory in full.
+ *
+ * @param states Parser states in file order
+ * @param count Number of states
+ * @param data_obj Pointer to the data_object struct
+ * @return OK if successful, ERROR otherwise
+ */
+static int states_to_object(parse_state *states, size_t count,
+                            data_object *data_obj) {
+  int status = OK;
+  size_t vertex_count = 0, index_count = 0, polygon_count = 0;
+  double min[3] = {HUGE_VAL, HUGE_VAL, HUGE_VAL};
+  double max[3] = {-HUGE_VAL, -HUGE_VAL, -HUGE_VAL};
+  double sum[3] = {0, 0, 0};
+  for (size_t i = 0; i < count; i++) {
+    for (int k = 0; k < 3; k++) {
+      if (states[i].min[k] < min[k]) min[k] = states[i].min[k];
+      if (states[i].max[k] > max[k]) max[k] = states[i].max[k];
+      sum[k] += states[i].sum[k];
+    }
+    for (size_t j = 0; j < states[i].relative_count; j++)
+      states[i].indices[states[i].relative[j]] += (unsigned int)vertex_count;
+    vertex_count += states[i].vertex_count;
+    index_count += states[i].index_count;
+    polygon_count += states[i].polygon_count;
+  }
+  for (size_t i = 0; status == OK && i < count; i++)
+    status = check_indices(&states[i], vertex_count);
+  char *memory = NULL;
+  if (status == OK) {
+    memory_reset(data_obj);
+    memory = arena_alloc(&data_obj->arena,
+                         vertex_bytes(vertex_count) +
+                             (polygon_count + 1) * sizeof(size_t) +
+                             index_count * sizeof(unsigned int));
+    if (!memory) {
+      memory_reset(data_obj);
+      status = ERROR;
+    }
+  }
+  if (status == OK) {
+    vertex_t *vertices = (vertex_t *)memory;
+    size_t *offsets = (size_t *)(memory + vertex_bytes(vertex_count));
+    unsigned int *indices = (unsigned int *)(offsets + polygon_count + 1);
+    memset(vertices, 0, 3 * sizeof(vertex_t));
+    offsets[0] = 0;
+    size_t vertex_base = 0, index_base = 0, polygon_base = 0;
+    for (size_t i = 0; i < count; i++) {
+      parse_state *chunk = &states[i];
+      vertex_t *to = vertices + (vertex_base + 1) * 3;
+      for (size_t j = 0; j < chunk->vertex_count * 3; j++)
+        to[j] = (vertex_t)chunk->vertices[j + 3];
+      free(chunk->vertices);
+      chunk->vertices = NULL;
+      if (chunk->index_count > 0)
+        memcpy(indices + index_base, chunk->indices,
+               chunk->index_count * sizeof(unsigned int));
+      free(chunk->indices);
+      chunk->indices = NULL;
+      for (size_t j = 1; j <= chunk->polygon_count; j++)
+        offsets[polygon_base + j] = chunk->offsets[j] + index_base;
+      free(chunk->offsets);
+      chunk->offsets = NULL;
+      vertex_base += chunk->vertex_count;
+      index_base += chunk->index_count;
+      polygon_base += chunk->polygon_count;
+    }
+    data_obj->vertex_count = vertex_count;
+    data_obj->vertex_array.matrix = vertices;
+    data_obj->vertex_array.rows = vertex_count + 1;
+    data_obj->vertex_array.colums = 3;
+    data_obj->polygon_count = polygon_count;
+    data_obj->index_array = indices;
+    data_obj->offset_array = offsets;
+    data_obj->edges_count = 0;
+    data_obj->all_edges_count = index_count;
+    for (int k = 0; vertex_count > 0 && k < 3; k++) {
+      data_obj->bbox_min[k] = min[k];
+      data_obj->bbox_max[k] = max[k];
+      data_obj->centroid[k] = sum[k] / (double)vertex_count;
+    }
+  }
+  return status;
+}
+
+/**
+ * @brief Parses an .obj file with the given options
+ *
+ * Reads the file once, collecting vertices and polygons into growable buffers,
+ * and copies them into the arena of the data_object on success. If the
+ * data_object already holds a model, its arena is reused for the new one.
+ *
+ * @param file_name Name of the .obj file to parse, "-" for stdin
+ * @param data_obj Pointer to the data_object struct, zeroed or holding a model
+ * @param options Parser options, NULL for defaults
+ * @return OK if successful, ERROR otherwise
+ */
+int parse_obj(char *file_name, data_object *data_obj,
+              const parser_options *options) {
+  if (file_name == NULL || data_obj == NULL) return ERROR;
+  parser_options defaults = {0};
+  parse_state *states = NULL;
+  size_t count = 0;
+  int status =
+      parse_file(file_name, options ? options : &defaults, &states, &count);
+  if (status == OK) status = states_to_object(states, count, data_obj);
+  states_free(states, count);
   return status;
 }
 
+/**
+ * @brief Main function for parsing an .obj file
+ *
+ * Maps regular files into memory and falls back to buffered reads otherwise.
+ *
+ * @param file_name Name of the .obj file to parse
+ * @param data_obj Pointer to the data_object struct
+ * @return OK if successful, ERROR otherwise
+ */
+int parser(char *file_name, data_object *data_obj) {
+  return parse_obj(file_name, data_obj, NULL);
+}
+
 /**
  * @brief Creates a new polygon array
  *
@@ -162,6 +663,60 @@ int create_polygon(size_t col, polygon_t *new_polygon) {
   return status;
 }
 
+/**
+ * @brief Returns a view of one polygon of a parsed object
+ *
+ * The view points into the index array of the object and must not be freed.
+ *
+ * @param data_obj Pointer to the data_object struct
+ * @param index Number of the polygon
+ * @return Polygon view, empty if the polygon does not exist
+ */
+polygon_t get_polygon(const data_object *data_obj, size_t index) {
+  polygon_t view = {NULL, 0};
+  if (data_obj && data_obj->offset_array && index < data_obj->polygon_count) {
+    view.polygon = data_obj->index_array + data_obj->offset_array[index];
+    view.colums =
+        data_obj->offset_array[index + 1] - data_obj->offset_array[index];
+  }
+  return view;
+}
+
+/**
+ * @brief Returns the size of a vertex matrix in bytes
+ *
+ * Includes the zero row and is rounded up to 8 bytes, so that the arrays
+ * stored after the vertices are aligned whatever the type of vertex_t.
+ *
+ * @param vertex_count Number of vertices
+ * @return Size in bytes
+ */
+size_t vertex_bytes(size_t vertex_count) {
+  return ((vertex_count + 1) * 3 * sizeof(vertex_t) + 7) & ~(size_t)7;
+}
+
+/**
+ * @brief Returns the largest absolute coordinate of a parsed object
+ *
+ * Read from the bounding box, so it takes constant time. The projection and
+ * the translation ranges of the viewer are scaled by this value.
+ *
+ * @param data_obj Pointer to the data_object struct
+ * @return Largest absolute coordinate, 1 for an object without vertices
+ */
+double model_extent(const data_object *data_obj) {
+  double extent = 0;
+  if (data_obj && data_obj->vertex_count > 0) {
+    for (int i = 0; i < 3; i++) {
+      if (fabs(data_obj->bbox_min[i]) > extent)
+        extent = fabs(data_obj->bbox_min[i]);
+      if (fabs(data_obj->bbox_max[i]) > extent)
+        extent = fabs(data_obj->bbox_max[i]);
+    }
+  }
+  return extent > 0 ? extent : 1;
+}
+
 /**
  * @brief Creates a new matrix
  *
@@ -177,7 +732,7 @@ int create_matrix(size_t rows, size_t colums, matrix_t *new_matrix) {
   if (rows > 0 && colums > 0) {
     new_matrix->rows = rows;
     new_matrix->colums = colums;
-    new_matrix->matrix = (double *)calloc(rows * colums, sizeof(double));
+    new_matrix->matrix = (vertex_t *)calloc(rows * colums, sizeof(vertex_t));
   } else {
     printf("Matrix creation ERROR");
     status = ERROR;
@@ -214,22 +769,33 @@ void memory_free_polygon(polygon_t *old_polygon) {
 /**
  * @brief Frees all allocated memory for the data_object
  *
- * Frees memory for vertex arrays, polygon arrays, and resets pointers.
+ * Returns the arena that holds the vertex, index and offset arrays to the
+ * system and resets pointers.
  *
  * @param data_obj Pointer to the data_object struct
  */
 void memory_free(data_object *data_obj) {
   if (data_obj != NULL) {
-    if (data_obj->vertex_array.matrix != NULL)
-      memory_free_matrix(&data_obj->vertex_array);
-    if (data_obj->polygon_array != NULL) {
-      for (size_t i = 0; i < data_obj->polygon_count; i++) {
-        if (data_obj->polygon_array[i].polygon != NULL)
-          memory_free_polygon(&data_obj->polygon_array[i]);
-      }
-      free(data_obj->polygon_array);
-      data_obj->polygon_array = NULL;
-    }
+    arena_release(&data_obj->arena);
+    memory_reset(data_obj);
     data_obj = NULL;
   }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Empties the data_object but keeps its memory for the next model
+ *
+ * Takes constant time regardless of the size of the model. A model loaded
+ * from the binary cache is unmapped.
+ *
+ * @param data_obj Pointer to the data_object struct
+ */
+void memory_reset(data_object *data_obj) {
+  if (data_obj != NULL) {
+    if (data_obj->mapping) munmap(data_obj->mapping, data_obj->mapping_size);
+    arena_t arena = data_obj->arena;
+    arena_reset(&arena);
+    memset(data_obj, 0, sizeof(data_object));
+    data_obj->arena = arena;
+  }
+}
@@ -0,0 +1,141 @@
+/**
+ * @file quantize.c
+ * @brief 16-bit quantized vertex storage for very large models
+ *
+ * A quantized model keeps every coordinate as a signed 16-bit step count
+ * from the centre of its bounding box, which takes a quarter of the memory of
+ * double vertices and half of float ones. The steps are chosen per axis so
+ * that the bounding box spans the whole 16-bit range. OpenGL decodes the
+ * positions in the vertex stage: they are drawn as GL_SHORT with the origin
+ * and step applied as a translation and a scale.
+ *
+ * Key features:
+ * - Quantization relative to the bounding box computed by the parser
+ * - Largest decoding error measured over all vertices
+ * - Decoding of single vertices on the CPU with get_vertex()
+ * - The full-precision vertices are released, so the memory is really saved
+ */
+
+#include "3DViever.h"
+
+/// Largest step count, the range is symmetric around the origin
+#define QUANT_MAX 32767
+
+/**
+ * @brief Computes the origin and step of every axis
+ *
+ * @param data_obj Pointer to the data_object struct
+ * @param quantized Filled origin and step
+ */
+static void quantize_grid(const data_object *data_obj, quantized_t *quantized) {
+  for (int k = 0; k < 3; k++) {
+    double half = (data_obj->bbox_max[k] - data_obj->bbox_min[k]) / 2;
+    quantized->origin[k] = data_obj->bbox_min[k] + half;
+    quantized->step[k] = half > 0 ? half / QUANT_MAX : 1;
+  }
+}
+
+/**
+ * @brief Quantizes the vertices of an object and drops the original ones
+ *
+ * The polygon arrays, the line list and the quantized positions are copied
+ * into a new arena; the old arena, or the mapping of a cached model, is
+ * released. The vertex matrix pointer of the object is NULL afterwards, use
+ * get_vertex() to read coordinates. On error the object is left as it was.
+ *
+ * @param data_obj Pointer to the data_object struct holding a parsed model
+ * @return OK if successful, ERROR otherwise
+ */
+int quantize_object(data_object *data_obj) {
+  int status = data_obj && data_obj->vertex_array.matrix ? OK : ERROR;
+  arena_t arena = {0};
+  char *memory = NULL;
+  size_t count = status == OK ? data_obj->vertex_count : 0;
+  size_t positions = ((count + 1) * 3 * sizeof(int16_t) + 7) & ~(size_t)7;
+  size_t offsets = status == OK ? (data_obj->polygon_count + 1) : 0;
+  size_t edges = status == OK && data_obj->edge_array
+                     ? data_obj->edges_count * 2
+                     : 0;
+  if (status == OK) {
+    memory = arena_alloc(&arena, positions + offsets * sizeof(size_t) +
+                                     (data_obj->all_edges_count + edges) *
+                                         sizeof(unsigned int));
+    if (!memory) status = ERROR;
+  }
+  if (status == OK) {
+    quantized_t quantized = {(int16_t *)memory, {0}, {0}, 0};
+    quantize_grid(data_obj, &quantized);
+    const vertex_t *source = data_obj->vertex_array.matrix;
+    memset(quantized.positions, 0, 3 * sizeof(int16_t));
+    for (size_t i = 3; i < (count + 1) * 3; i++) {
+      int k = i % 3;
+      double steps = round((source[i] - quantized.origin[k]) /
+                           quantized.step[k]);
+      if (steps > QUANT_MAX) steps = QUANT_MAX;
+      if (steps < -QUANT_MAX) steps = -QUANT_MAX;
+      quantized.positions[i] = (int16_t)steps;
+      double error =
+          fabs(quantized.origin[k] + steps * quantized.step[k] - source[i]);
+      if (error > quantized.max_error) quantized.max_error = error;
+    }
+    size_t *offset_array = (size_t *)(memory + positions);
+    unsigned int *index_array = (unsigned int *)(offset_array + offsets);
+    memcpy(offset_array, data_obj->offset_array, offsets * sizeof(size_t));
+    unsigned int *edge_array = index_array + data_obj->all_edges_count;
+    if (data_obj->all_edges_count > 0)
+      memcpy(index_array, data_obj->index_array,
+             data_obj->all_edges_count * sizeof(unsigned int));
+    if (edges > 0)
+      memcpy(edge_array, data_obj->edge_array, edges * sizeof(unsigned int));
+    data_object model = *data_obj;
+    arena_release(&data_obj->arena);
+    memory_reset(data_obj);
+    model.vertex_array.matrix = NULL;
+    model.offset_array = offset_array;
+    model.index_array = index_array;
+    if (model.edge_array) model.edge_array = edge_array;
+    model.arena = arena;
+    model.mapping = NULL;
+    model.mapping_size = 0;
+    model.quantized = quantized;
+    *data_obj = model;
+  }
+  if (status != OK) arena_release(&arena);
+  return status;
+}
+
+/**
+ * @brief Reads the coordinates of one vertex of an object
+ *
+ * Works for both the full-precision and the quantized storage.
+ *
+ * @param data_obj Pointer to the data_object struct
+ * @param index Number of the vertex, from 1 to vertex_count
+ * @param xyz Coordinates, zero if the vertex does not exist
+ */
+void get_vertex(const data_object *data_obj, size_t index, double *xyz) {
+  xyz[0] = xyz[1] = xyz[2] = 0;
+  if (data_obj && index >= 1 && index <= data_obj->vertex_count) {
+    if (data_obj->vertex_array.matrix) {
+      for (int k = 0; k < 3; k++)
+        xyz[k] = data_obj->vertex_array.matrix[index * 3 + k];
+    } else if (data_obj->quantized.positions) {
+      const quantized_t *quantized = &data_obj->quantized;
+      for (int k = 0; k < 3; k++)
+        xyz[k] = quantized->origin[k] +
+                 quantized->positions[index * 3 + k] * quantized->step[k];
+    }
+  }
+}
+
+/**
+ * @brief Returns the memory held by a model
+ *
+ * Counts the used part of the arena and the mapping of a cached model.
+ *
+ * @param data_obj Pointer to the data_object struct
+ * @return Size in bytes
+ */
+size_t model_memory(const data_object *data_obj) {
+  return data_obj ? data_obj->arena.used + data_obj->mapping_size : 0;
+}
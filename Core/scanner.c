@@ -0,0 +1,232 @@
+/**
+ * @file scanner.c
+ * @brief Locale-independent number scanning for .obj records
+ *
+ * This module reads the numbers of "v" and "f" records straight from the file
+ * bytes. Unlike sscanf(), strtod() and atoi() it does not depend on the
+ * current locale, does not need null-terminated input and never reads past
+ * the end of the line it is given.
+ *
+ * Key features:
+ * - Decimal numbers with optional sign, fraction and exponent
+ * - Signed (relative) face indices
+ * - "v", "v/vt", "v//vn" and "v/vt/vn" face triplets
+ * - Results that are bit-exact with strtod()
+ *
+ * Numbers with at most 19 significant digits and a decimal exponent within
+ * +-22 are converted with a single correctly rounded multiplication or
+ * division, which is exact. Everything else is handed to strtod() with the
+ * decimal separator of the current locale.
+ */
+
+#include <locale.h>
+#include <stdint.h>
+
+#include "3DViever.h"
+
+/// Longest token that is copied to the stack for the strtod() fallback
+#define SCAN_TOKEN_MAX 128
+
+/// Powers of ten that are exactly representable as doubles
+static const double exact_powers[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/**
+ * @brief Checks for a blank character in the "C" locale
+ *
+ * @param c Character
+ * @return Non-zero for a blank
+ */
+static inline int is_blank(char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/**
+ * @brief Checks for a decimal digit
+ *
+ * @param c Character
+ * @return Non-zero for a digit
+ */
+static inline int is_digit(char c) { return (unsigned char)(c - '0') < 10; }
+
+/**
+ * @brief Checks whether a character terminates a token
+ *
+ * @param pos Current position
+ * @param end End of the line
+ * @return Non-zero at the end of the line or on a blank
+ */
+static int token_end(const char *pos, const char *end) {
+  return pos >= end || is_blank(*pos);
+}
+
+/**
+ * @brief Converts a token with strtod() regardless of the current locale
+ *
+ * The token is copied so that it is null-terminated, and its '.' is replaced
+ * with the decimal separator strtod() expects in the current locale.
+ *
+ * @param begin Start of the token
+ * @param end End of the token
+ * @param value Converted value
+ * @return OK if the whole token was converted, ERROR otherwise
+ */
+static int slow_double(const char *begin, const char *end, double *value) {
+  int status = OK;
+  size_t len = end - begin;
+  const char *point = localeconv()->decimal_point;
+  size_t point_len = strlen(point);
+  char stack[SCAN_TOKEN_MAX];
+  char *token = len * point_len < sizeof(stack) ? stack
+                                                : malloc(len * point_len + 1);
+  if (token) {
+    size_t n = 0;
+    for (const char *pos = begin; pos < end; pos++) {
+      if (*pos == '.') {
+        memcpy(token + n, point, point_len);
+        n += point_len;
+      } else
+        token[n++] = *pos;
+    }
+    token[n] = '\0';
+    char *stop = NULL;
+    *value = strtod(token, &stop);
+    if (stop != token + n) status = ERROR;
+    if (token != stack) free(token);
+  } else
+    status = ERROR;
+  return status;
+}
+
+/**
+ * @brief Reads a floating-point number
+ *
+ * Leading blanks are skipped. The number has to be followed by a blank or the
+ * end of the line.
+ *
+ * @param pos Address of the current position, moved past the number
+ * @param end End of the line
+ * @param value Converted value
+ * @return OK if successful, ERROR otherwise
+ */
+int scan_double(const char **pos, const char *end, double *value) {
+  const char *p = *pos;
+  while (p < end && is_blank(*p)) p++;
+  const char *begin = p;
+  int negative = 0;
+  if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+  uint64_t mantissa = 0;
+  int digits = 0, significant = 0, exponent = 0;
+  for (; p < end && is_digit(*p); p++, digits++) {
+    if (mantissa || *p != '0') {
+      if (significant++ < 19) mantissa = mantissa * 10 + (*p - '0');
+      else
+        exponent++;
+    }
+  }
+  if (p < end && *p == '.') {
+    for (p++; p < end && is_digit(*p); p++, digits++) {
+      if (mantissa || *p != '0') {
+        if (significant++ < 19) {
+          mantissa = mantissa * 10 + (*p - '0');
+          exponent--;
+        }
+      } else
+        exponent--;
+    }
+  }
+  int status = digits > 0 ? OK : ERROR;
+  if (status == OK && p < end && (*p == 'e' || *p == 'E')) {
+    const char *q = p + 1;
+    int exp_negative = 0, exp_value = 0;
+    if (q < end && (*q == '-' || *q == '+')) exp_negative = *q++ == '-';
+    if (q < end && is_digit(*q)) {
+      for (; q < end && is_digit(*q); q++)
+        if (exp_value < 100000) exp_value = exp_value * 10 + (*q - '0');
+      exponent += exp_negative ? -exp_value : exp_value;
+      p = q;
+    }
+  }
+  if (status == OK && !token_end(p, end)) {
+    // inf, nan, hexadecimal numbers and malformed tokens
+    while (!token_end(p, end)) p++;
+    status = slow_double(begin, p, value);
+  } else if (status == OK) {
+    if (significant > 19 || mantissa > ((uint64_t)1 << 53) ||
+        exponent < -22 || exponent > 22) {
+      status = slow_double(begin, p, value);
+    } else {
+      double result = (double)mantissa;
+      if (exponent < 0)
+        result /= exact_powers[-exponent];
+      else
+        result *= exact_powers[exponent];
+      *value = negative ? -result : result;
+    }
+  }
+  if (status == OK) *pos = p;
+  return status;
+}
+
+/**
+ * @brief Reads a signed integer
+ *
+ * Leading blanks are skipped. The number ends at the first character that is
+ * not a digit.
+ *
+ * @param pos Address of the current position, moved past the number
+ * @param end End of the line
+ * @param value Converted value
+ * @return OK if successful, ERROR otherwise
+ */
+int scan_index(const char **pos, const char *end, long *value) {
+  const char *p = *pos;
+  while (p < end && is_blank(*p)) p++;
+  int negative = 0;
+  if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+  const char *digits = p;
+  unsigned long result = 0;
+  for (; p < end && is_digit(*p); p++)
+    if (result < 0x7FFFFFFFUL) result = result * 10 + (*p - '0');
+  int status = p > digits && result <= 0x7FFFFFFFUL ? OK : ERROR;
+  if (status == OK) {
+    *value = negative ? -(long)result : (long)result;
+    *pos = p;
+  }
+  return status;
+}
+
+/**
+ * @brief Reads one vertex reference of a face record
+ *
+ * Accepts "v", "v/vt", "v//vn" and "v/vt/vn". Missing texture and normal
+ * indices are returned as 0. The reference has to be followed by a blank or
+ * the end of the line.
+ *
+ * @param pos Address of the current position, moved past the reference
+ * @param end End of the line
+ * @param v Vertex index
+ * @param vt Texture coordinate index, may be NULL
+ * @param vn Normal index, may be NULL
+ * @return OK if successful, ERROR otherwise
+ */
+int scan_face_vertex(const char **pos, const char *end, long *v, long *vt,
+                     long *vn) {
+  const char *p = *pos;
+  long indices[3] = {0, 0, 0};
+  int status = scan_index(&p, end, &indices[0]);
+  for (int i = 1; status == OK && i < 3 && p < end && *p == '/'; i++) {
+    p++;
+    if (p < end && *p != '/' && !is_blank(*p))
+      status = scan_index(&p, end, &indices[i]);
+  }
+  if (status == OK && !token_end(p, end)) status = ERROR;
+  if (status == OK) {
+    *v = indices[0];
+    if (vt) *vt = indices[1];
+    if (vn) *vn = indices[2];
+    *pos = p;
+  }
+  return status;
+}
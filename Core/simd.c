@@ -0,0 +1,380 @@
+/**
+ * @file simd.c
+ * @brief Vectorized transformations of vertices in a structure-of-arrays layout
+ *
+ * The vertex matrix of a data_object interleaves x, y and z, so every loop
+ * over it steps by three doubles and cannot be vectorized well. This module
+ * keeps the coordinates in three separate arrays instead and transforms them
+ * with kernels written for the vector units of the CPU.
+ *
+ * Key features:
+ * - Conversion between the vertex matrix and the SoA layout
+ * - Move, rotate, scale and generic 4x4 transformation kernels
+ * - AVX2 and SSE2 kernels on x86, chosen at runtime from the CPU features
+ * - Scalar kernels everywhere else
+ * - Sines and cosines computed once per call, not once per vertex
+ *
+ * All kernels perform the same operations in the same order without fused
+ * multiply-add, so every level gives bit-identical results.
+ */
+
+#include "3DViever.h"
+
+#include <stdatomic.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+ * @struct simd_kernels
+ * @brief Kernels of one instruction set
+ *
+ * add() and mul() work on a single coordinate array, mix() rotates the pair
+ * (a, b) to (a * c + b * s, b * c - a * s), and transform() applies the upper
+ * three rows of a column-major 4x4 matrix.
+ */
+typedef struct simd_kernels {
+  void (*add)(double *a, size_t count, double value);
+  void (*mul)(double *a, size_t count, double value);
+  void (*mix)(double *a, double *b, size_t count, double c, double s);
+  void (*transform)(double *x, double *y, double *z, size_t count,
+                    const double *m);
+} simd_kernels;
+
+/// Kernel level in use, -1 until it has been detected
+static atomic_int current_level = -1;
+
+static void scalar_add(double *a, size_t count, double value) {
+  for (size_t i = 0; i < count; i++) a[i] += value;
+}
+
+static void scalar_mul(double *a, size_t count, double value) {
+  for (size_t i = 0; i < count; i++) a[i] *= value;
+}
+
+static void scalar_mix(double *a, double *b, size_t count, double c,
+                       double s) {
+  for (size_t i = 0; i < count; i++) {
+    double u = a[i], v = b[i];
+    a[i] = u * c + v * s;
+    b[i] = v * c - u * s;
+  }
+}
+
+static void scalar_transform(double *x, double *y, double *z, size_t count,
+                             const double *m) {
+  for (size_t i = 0; i < count; i++) {
+    double u = x[i], v = y[i], w = z[i];
+    x[i] = m[0] * u + m[4] * v + m[8] * w + m[12];
+    y[i] = m[1] * u + m[5] * v + m[9] * w + m[13];
+    z[i] = m[2] * u + m[6] * v + m[10] * w + m[14];
+  }
+}
+
+#ifdef SIMD_X86
+
+__attribute__((target("sse2"))) static void sse2_add(double *a, size_t count,
+                                                     double value) {
+  __m128d k = _mm_set1_pd(value);
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2)
+    _mm_storeu_pd(a + i, _mm_add_pd(_mm_loadu_pd(a + i), k));
+  scalar_add(a + i, count - i, value);
+}
+
+__attribute__((target("sse2"))) static void sse2_mul(double *a, size_t count,
+                                                     double value) {
+  __m128d k = _mm_set1_pd(value);
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2)
+    _mm_storeu_pd(a + i, _mm_mul_pd(_mm_loadu_pd(a + i), k));
+  scalar_mul(a + i, count - i, value);
+}
+
+__attribute__((target("sse2"))) static void sse2_mix(double *a, double *b,
+                                                     size_t count, double c,
+                                                     double s) {
+  __m128d kc = _mm_set1_pd(c), ks = _mm_set1_pd(s);
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    __m128d u = _mm_loadu_pd(a + i), v = _mm_loadu_pd(b + i);
+    _mm_storeu_pd(a + i, _mm_add_pd(_mm_mul_pd(u, kc), _mm_mul_pd(v, ks)));
+    _mm_storeu_pd(b + i, _mm_sub_pd(_mm_mul_pd(v, kc), _mm_mul_pd(u, ks)));
+  }
+  scalar_mix(a + i, b + i, count - i, c, s);
+}
+
+__attribute__((target("sse2"))) static void sse2_transform(
+    double *x, double *y, double *z, size_t count, const double *m) {
+  __m128d k[12];
+  for (int j = 0; j < 12; j++) k[j] = _mm_set1_pd(m[j + (j / 3)]);
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    __m128d u = _mm_loadu_pd(x + i), v = _mm_loadu_pd(y + i),
+            w = _mm_loadu_pd(z + i);
+    double *out[3] = {x + i, y + i, z + i};
+    for (int row = 0; row < 3; row++) {
+      __m128d r = _mm_add_pd(_mm_mul_pd(k[row], u), _mm_mul_pd(k[3 + row], v));
+      r = _mm_add_pd(_mm_add_pd(r, _mm_mul_pd(k[6 + row], w)), k[9 + row]);
+      _mm_storeu_pd(out[row], r);
+    }
+  }
+  scalar_transform(x + i, y + i, z + i, count - i, m);
+}
+
+__attribute__((target("avx2"))) static void avx2_add(double *a, size_t count,
+                                                     double value) {
+  __m256d k = _mm256_set1_pd(value);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    _mm256_storeu_pd(a + i, _mm256_add_pd(_mm256_loadu_pd(a + i), k));
+  scalar_add(a + i, count - i, value);
+}
+
+__attribute__((target("avx2"))) static void avx2_mul(double *a, size_t count,
+                                                     double value) {
+  __m256d k = _mm256_set1_pd(value);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    _mm256_storeu_pd(a + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), k));
+  scalar_mul(a + i, count - i, value);
+}
+
+__attribute__((target("avx2"))) static void avx2_mix(double *a, double *b,
+                                                     size_t count, double c,
+                                                     double s) {
+  __m256d kc = _mm256_set1_pd(c), ks = _mm256_set1_pd(s);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256d u = _mm256_loadu_pd(a + i), v = _mm256_loadu_pd(b + i);
+    _mm256_storeu_pd(a + i, _mm256_add_pd(_mm256_mul_pd(u, kc),
+                                          _mm256_mul_pd(v, ks)));
+    _mm256_storeu_pd(b + i, _mm256_sub_pd(_mm256_mul_pd(v, kc),
+                                          _mm256_mul_pd(u, ks)));
+  }
+  scalar_mix(a + i, b + i, count - i, c, s);
+}
+
+__attribute__((target("avx2"))) static void avx2_transform(
+    double *x, double *y, double *z, size_t count, const double *m) {
+  __m256d k[12];
+  for (int j = 0; j < 12; j++) k[j] = _mm256_set1_pd(m[j + (j / 3)]);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256d u = _mm256_loadu_pd(x + i), v = _mm256_loadu_pd(y + i),
+            w = _mm256_loadu_pd(z + i);
+    double *out[3] = {x + i, y + i, z + i};
+    for (int row = 0; row < 3; row++) {
+      __m256d r =
+          _mm256_add_pd(_mm256_mul_pd(k[row], u), _mm256_mul_pd(k[3 + row], v));
+      r = _mm256_add_pd(_mm256_add_pd(r, _mm256_mul_pd(k[6 + row], w)),
+                        k[9 + row]);
+      _mm256_storeu_pd(out[row], r);
+    }
+  }
+  scalar_transform(x + i, y + i, z + i, count - i, m);
+}
+
+#endif
+
+/// Kernels indexed by enum simd_level
+static const simd_kernels kernels[] = {
+    {scalar_add, scalar_mul, scalar_mix, scalar_transform},
+#ifdef SIMD_X86
+    {sse2_add, sse2_mul, sse2_mix, sse2_transform},
+    {avx2_add, avx2_mul, avx2_mix, avx2_transform},
+#endif
+};
+
+/**
+ * @brief Returns the best kernel level supported by the CPU
+ *
+ * @return Value of enum simd_level
+ */
+static int simd_detect(void) {
+  int level = SIMD_SCALAR;
+#ifdef SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    level = SIMD_AVX2;
+  else if (__builtin_cpu_supports("sse2"))
+    level = SIMD_SSE2;
+#endif
+  return level;
+}
+
+/**
+ * @brief Returns the kernels currently in use
+ *
+ * @return Kernel table
+ */
+static const simd_kernels *simd_kernels_get(void) {
+  return &kernels[simd_level()];
+}
+
+/**
+ * @brief Returns the kernel level in use
+ *
+ * The level is detected from the CPU on the first call.
+ *
+ * @return Value of enum simd_level
+ */
+int simd_level(void) {
+  int level = atomic_load(&current_level);
+  if (level < 0) {
+    level = simd_detect();
+    atomic_store(&current_level, level);
+  }
+  return level;
+}
+
+/**
+ * @brief Selects the kernel level, for benchmarks and tests
+ *
+ * Levels the CPU does not support are lowered to the best supported one.
+ *
+ * @param level Value of enum simd_level
+ * @return Level actually selected
+ */
+int simd_set_level(int level) {
+  int best = simd_detect();
+  if (level < SIMD_SCALAR) level = SIMD_SCALAR;
+  if (level > best) level = best;
+  atomic_store(&current_level, level);
+  return level;
+}
+
+/**
+ * @brief Copies the vertices of an object into the SoA layout
+ *
+ * The three arrays are allocated from the arena of the object, so they stay
+ * valid until the object is reset or freed. Each array is 64-byte aligned.
+ *
+ * @param data_obj Pointer to the data_object struct
+ * @param soa Filled with the coordinates of vertices 1 to vertex_count
+ * @return OK if successful, ERROR otherwise
+ */
+int soa_load(data_object *data_obj, vertex_soa *soa) {
+  int status = data_obj && data_obj->vertex_array.matrix && soa ? OK : ERROR;
+  if (status == OK) {
+    size_t count = data_obj->vertex_count;
+    size_t stride = (count + 7) & ~(size_t)7;
+    double *memory = arena_alloc(&data_obj->arena, 3 * stride * sizeof(double));
+    if (memory) {
+      soa->x = memory;
+      soa->y = memory + stride;
+      soa->z = memory + 2 * stride;
+      soa->count = count;
+      const vertex_t *row = data_obj->vertex_array.matrix + 3;
+      for (size_t i = 0; i < count; i++, row += 3) {
+        soa->x[i] = row[0];
+        soa->y[i] = row[1];
+        soa->z[i] = row[2];
+      }
+    } else
+      status = ERROR;
+  }
+  return status;
+}
+
+/**
+ * @brief Copies SoA coordinates back into the vertex matrix of an object
+ *
+ * @param soa Coordinates
+ * @param data_obj Pointer to the data_object struct with soa->count vertices
+ */
+void soa_store(const vertex_soa *soa, data_object *data_obj) {
+  if (soa && data_obj && data_obj->vertex_count == soa->count) {
+    vertex_t *row = data_obj->vertex_array.matrix + 3;
+    for (size_t i = 0; i < soa->count; i++, row += 3) {
+      row[0] = (vertex_t)soa->x[i];
+      row[1] = (vertex_t)soa->y[i];
+      row[2] = (vertex_t)soa->z[i];
+    }
+  }
+}
+
+/**
+ * @brief Moves the vertices by the given offsets
+ *
+ * @param soa Coordinates
+ * @param dx Offset along the X-axis
+ * @param dy Offset along the Y-axis
+ * @param dz Offset along the Z-axis
+ */
+void soa_move(vertex_soa *soa, double dx, double dy, double dz) {
+  const simd_kernels *k = simd_kernels_get();
+  if (dx != 0) k->add(soa->x, soa->count, dx);
+  if (dy != 0) k->add(soa->y, soa->count, dy);
+  if (dz != 0) k->add(soa->z, soa->count, dz);
+}
+
+/**
+ * @brief Rotates the vertices around the X-axis
+ *
+ * Uses the same direction of rotation as rotate_x().
+ *
+ * @param soa Coordinates
+ * @param angle Rotation angle in degrees
+ */
+void soa_rotate_x(vertex_soa *soa, double angle) {
+  double radians = angle * M_PI / 180.0;
+  simd_kernels_get()->mix(soa->y, soa->z, soa->count, cos(radians),
+                          sin(radians));
+}
+
+/**
+ * @brief Rotates the vertices around the Y-axis
+ *
+ * Uses the same direction of rotation as rotate_y().
+ *
+ * @param soa Coordinates
+ * @param angle Rotation angle in degrees
+ */
+void soa_rotate_y(vertex_soa *soa, double angle) {
+  double radians = angle * M_PI / 180.0;
+  simd_kernels_get()->mix(soa->x, soa->z, soa->count, cos(radians),
+                          sin(radians));
+}
+
+/**
+ * @brief Rotates the vertices around the Z-axis
+ *
+ * Uses the same direction of rotation as rotate_z().
+ *
+ * @param soa Coordinates
+ * @param angle Rotation angle in degrees
+ */
+void soa_rotate_z(vertex_soa *soa, double angle) {
+  double radians = angle * M_PI / 180.0;
+  simd_kernels_get()->mix(soa->x, soa->y, soa->count, cos(radians),
+                          -sin(radians));
+}
+
+/**
+ * @brief Scales the vertices uniformly
+ *
+ * @param soa Coordinates
+ * @param factor Scale factor
+ */
+void soa_scale(vertex_soa *soa, double factor) {
+  const simd_kernels *k = simd_kernels_get();
+  k->mul(soa->x, soa->count, factor);
+  k->mul(soa->y, soa->count, factor);
+  k->mul(soa->z, soa->count, factor);
+}
+
+/**
+ * @brief Transforms the vertices with a model matrix
+ *
+ * The bottom row of the matrix is assumed to be 0 0 0 1, as it is for every
+ * matrix built with the model_*() functions.
+ *
+ * @param soa Coordinates
+ * @param matrix Column-major 4x4 model matrix
+ */
+void soa_transform(vertex_soa *soa, const double *matrix) {
+  simd_kernels_get()->transform(soa->x, soa->y, soa->z, soa->count, matrix);
+}
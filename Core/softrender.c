@@ -0,0 +1,740 @@
+/**
+ * @file softrender.c
+ * @brief Wireframe and point renderer that runs on the CPU only
+ *
+ * Renders a data_object into an RGBA buffer without OpenGL, a display or a
+ * GPU, for thumbnails and previews made on build servers. The renderer
+ * follows the fixed-function pipeline that GLWid drives, so that its images
+ * look like the ones on screen:
+ * - the same frustum and orthographic projections as GLWid::select_projection
+ * - clipping of lines and points against the view volume
+ * - lines rasterized like OpenGL lines, with the last pixel left out, wide
+ *   lines as columns or rows of pixels and the glLineStipple(2, 0x00FF)
+ *   pattern restarting at every segment
+ * - square points and round (smooth) points of the given size
+ * - a depth buffer with the GL_LESS test
+ *
+ * The image is split into square tiles. Lines and points are first sorted
+ * into the tiles their bounding boxes touch, then every tile is rasterized
+ * on its own by a thread pool, with a depth buffer of the size of one tile.
+ * A tile draws its primitives in the order of the model, so the image does
+ * not depend on the number of threads. A single thread skips the binning and
+ * draws the whole image as one tile.
+ *
+ * Key features:
+ * - Works on full-precision and quantized models through get_vertex()
+ * - Output is 8-bit RGBA, top row first, ready for a QImage
+ * - Vertex transformation, binning and rasterization run in parallel
+ * - Vertices are projected once; only lines crossing the border of the view
+ *   volume are clipped
+ */
+
+#include "3DViever.h"
+
+#include <stdint.h>
+
+/// Pattern and repeat factor of dashed lines, as in GLWid::select_line_type
+#define STIPPLE_PATTERN 0x00FF
+#define STIPPLE_FACTOR 2
+/// Side of a tile in pixels
+#define TILE_SIZE 64
+/// Vertices or primitives handled by one task of the thread pool
+#define RENDER_CHUNK ((size_t)65536)
+
+/**
+ * @struct raster
+ * @brief Tile being rendered into
+ *
+ * Window coordinates follow OpenGL, so the tile covers x0 <= x < x1 and
+ * y0 <= y < y1 counted from the bottom left corner of the image.
+ */
+typedef struct raster {
+  unsigned char *pixels;
+  float *depth;
+  int width;
+  int height;
+  int x0;
+  int y0;
+  int x1;
+  int y1;
+} raster_t;
+
+/**
+ * @struct render_job
+ * @brief Data shared by the tasks of one soft_render() call
+ *
+ * Primitives are numbered in drawing order: lines 0 to line_count - 1, then
+ * points for vertices 1 to point_count. Every vertex has an outcode with one
+ * bit per clipping plane it lies outside of and, if the outcode is zero,
+ * window coordinates; lines that leave the view volume are clipped from
+ * coordinates computed again when needed. rects holds the first and last
+ * tile column and row of every primitive, counts the number of entries of
+ * every tile for every binning chunk; bins lists the primitives of tile t
+ * from bin_offsets[t] to bin_offsets[t + 1]. With a single thread the whole
+ * image is one tile with the depth buffer depth and nothing is binned.
+ */
+typedef struct render_job {
+  const data_object *data_obj;
+  const render_settings *settings;
+  double matrix[16];
+  double *window;
+  unsigned char *outcodes;
+  const unsigned int *lines;
+  size_t line_count;
+  size_t point_count;
+  int line_width;
+  unsigned char background[4];
+  unsigned char line[4];
+  unsigned char point[4];
+  int tile_width;
+  int tile_height;
+  int tiles_x;
+  int tiles_y;
+  float *depth;
+  uint16_t *rects;
+  size_t *counts;
+  size_t *bin_offsets;
+  uint32_t *bins;
+  unsigned char *pixels;
+} render_job;
+
+/**
+ * @brief Rounds down to an integer
+ *
+ * Same as floor() for the window coordinates used here, but inlined; the
+ * rasterizer calls it for every fragment.
+ *
+ * @param value Finite value within the range of long
+ * @return Largest integer not greater than value
+ */
+static inline long floor_long(double value) {
+  long result = (long)value;
+  return result - (value < result);
+}
+
+/**
+ * @brief Rounds up to an integer
+ *
+ * @param value Finite value within the range of long
+ * @return Smallest integer not less than value
+ */
+static inline long ceil_long(double value) { return -floor_long(-value); }
+
+/**
+ * @brief Multiplies two column-major 4x4 matrices
+ *
+ * @param a Left matrix
+ * @param b Right matrix
+ * @param result a * b, may not alias a or b
+ */
+static void matrix_multiply(const double *a, const double *b, double *result) {
+  for (int col = 0; col < 4; col++)
+    for (int row = 0; row < 4; row++) {
+      double sum = 0;
+      for (int k = 0; k < 4; k++) sum += a[k * 4 + row] * b[col * 4 + k];
+      result[col * 4 + row] = sum;
+    }
+}
+
+/**
+ * @brief Builds the projection matrix that GLWid uses
+ *
+ * Central projection is glFrustum() followed by a translation along Z,
+ * parallel projection is glOrtho(), both sized by the extent of the model.
+ *
+ * @param settings Render settings
+ * @param matrix Column-major projection matrix
+ */
+static void projection_matrix(const render_settings *settings,
+                              double *matrix) {
+  double e = settings->extent;
+  memset(matrix, 0, 16 * sizeof(double));
+  if (settings->projection == 1) {
+    double n = e, f = 10 * e;
+    matrix[0] = 2 * n / (2 * e);
+    matrix[5] = 2 * n / (2 * e);
+    matrix[10] = -(f + n) / (f - n);
+    matrix[11] = -1;
+    matrix[14] = -2 * f * n / (f - n);
+    // glTranslatef(0, 0, -2.2 * e)
+    double shift = (float)(-2.2 * e);
+    matrix[12] += matrix[8] * shift;
+    matrix[13] += matrix[9] * shift;
+    matrix[14] += matrix[10] * shift;
+    matrix[15] += matrix[11] * shift;
+  } else {
+    double n = -1.1 * e, f = 10 * e;
+    matrix[0] = 2 / (2.2 * e);
+    matrix[5] = 2 / (2.2 * e);
+    matrix[10] = -2 / (f - n);
+    matrix[14] = -(f + n) / (f - n);
+    matrix[15] = 1;
+  }
+}
+
+/**
+ * @brief Clips a segment in clip coordinates against the view volume
+ *
+ * Liang-Barsky clipping against the six planes -w <= x, y, z <= w. Ends
+ * inside the view volume are left untouched.
+ *
+ * @param a First end, replaced by the clipped one
+ * @param b Second end, replaced by the clipped one
+ * @return 1 if a part of the segment is visible, 0 otherwise
+ */
+static int clip_segment(double *a, double *b) {
+  double t0 = 0, t1 = 1;
+  int visible = 1;
+  for (int plane = 0; plane < 6 && visible; plane++) {
+    int axis = plane / 2;
+    double sign = plane % 2 ? -1 : 1;
+    double da = a[3] + sign * a[axis], db = b[3] + sign * b[axis];
+    if (da < 0 && db < 0) {
+      visible = 0;
+    } else if (da < 0) {
+      double t = da / (da - db);
+      if (t > t0) t0 = t;
+    } else if (db < 0) {
+      double t = da / (da - db);
+      if (t < t1) t1 = t;
+    }
+    if (t0 > t1) visible = 0;
+  }
+  if (visible) {
+    double start[4], end[4];
+    for (int k = 0; k < 4; k++) {
+      start[k] = a[k] + t0 * (b[k] - a[k]);
+      end[k] = a[k] + t1 * (b[k] - a[k]);
+    }
+    if (t0 > 0) memcpy(a, start, sizeof(start));
+    if (t1 < 1) memcpy(b, end, sizeof(end));
+  }
+  return visible;
+}
+
+/**
+ * @brief Maps clip coordinates to window coordinates
+ *
+ * Window coordinates follow OpenGL: y grows upwards and the depth goes from
+ * 0 at the near plane to 1 at the far plane.
+ *
+ * @param settings Render settings with the size of the image
+ * @param clip Clip coordinates with w > 0
+ * @param window Window x, y and depth
+ */
+static void to_window(const render_settings *settings, const double *clip,
+                      double *window) {
+  window[0] = (clip[0] / clip[3] + 1) * settings->width / 2;
+  window[1] = (clip[1] / clip[3] + 1) * settings->height / 2;
+  window[2] = (clip[2] / clip[3] + 1) / 2;
+}
+
+/**
+ * @brief Writes one fragment if it lies in the tile and passes the depth test
+ *
+ * @param target Tile being rendered into
+ * @param x Column, counted from the left
+ * @param y Row, counted from the bottom as in OpenGL
+ * @param depth Window depth of the fragment
+ * @param color Red, green, blue and alpha bytes
+ */
+static void plot(raster_t *target, long x, long y, double depth,
+                 const unsigned char *color) {
+  if (x >= target->x0 && y >= target->y0 && x < target->x1 &&
+      y < target->y1) {
+    float *stored = target->depth +
+                    (size_t)(y - target->y0) * (target->x1 - target->x0) +
+                    (x - target->x0);
+    if ((float)depth < *stored) {
+      *stored = (float)depth;
+      memcpy(target->pixels +
+                 ((size_t)(target->height - 1 - y) * target->width + x) * 4,
+             color, 4);
+    }
+  }
+}
+
+/**
+ * @brief Rasterizes the part of a line segment that lies in a tile
+ *
+ * One fragment is made for every pixel centre along the major axis from the
+ * first end up to, but not including, the second one. A line wider than one
+ * pixel becomes a column (or row) of width fragments centred on the line.
+ * The stipple counter starts at the first end, wherever the tile is.
+ *
+ * @param target Tile being rendered into
+ * @param p0 First end in window coordinates
+ * @param p1 Second end in window coordinates
+ * @param width Line width in pixels
+ * @param dashed Whether the stipple pattern is applied
+ * @param color Red, green, blue and alpha bytes
+ */
+static void draw_line(raster_t *target, const double *p0, const double *p1,
+                      int width, int dashed, const unsigned char *color) {
+  int major = fabs(p1[0] - p0[0]) >= fabs(p1[1] - p0[1]) ? 0 : 1;
+  int minor = 1 - major;
+  double a0 = p0[major], a1 = p1[major];
+  if (a0 != a1) {
+    long first, last, step;
+    if (a1 > a0) {
+      first = ceil_long(a0 - 0.5);
+      last = ceil_long(a1 - 0.5) - 1;
+      step = 1;
+    } else {
+      first = floor_long(a0 - 0.5);
+      last = floor_long(a1 - 0.5) + 1;
+      step = -1;
+    }
+    // Отрезок короче пикселя может не задеть ни одного центра: last < first
+    long low = step > 0 ? first : last, high = step > 0 ? last : first;
+    long tile_low = major ? target->y0 : target->x0;
+    long tile_high = (major ? target->y1 : target->x1) - 1;
+    if (low < tile_low) low = tile_low;
+    if (high > tile_high) high = tile_high;
+    for (long k = low; k <= high; k++) {
+      long counter = (k - first) * step;
+      if (dashed &&
+          !((STIPPLE_PATTERN >> ((counter / STIPPLE_FACTOR) % 16)) & 1))
+        continue;
+      double t = (k + 0.5 - a0) / (a1 - a0);
+      long m = floor_long(p0[minor] + t * (p1[minor] - p0[minor]) -
+                          width / 2.0 + 0.5);
+      double depth = p0[2] + t * (p1[2] - p0[2]);
+      for (long j = m; j < m + width; j++) {
+        if (major == 0)
+          plot(target, k, j, depth, color);
+        else
+          plot(target, j, k, depth, color);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Rasterizes the part of a point that lies in a tile
+ *
+ * A square point covers size x size pixels around the point, a round point
+ * the pixels whose centres are within size / 2 of it.
+ *
+ * @param target Tile being rendered into
+ * @param p Point in window coordinates
+ * @param size Point size in pixels
+ * @param round_point Whether the point is round
+ * @param color Red, green, blue and alpha bytes
+ */
+static void draw_point(raster_t *target, const double *p, double size,
+                       int round_point, const unsigned char *color) {
+  if (round_point) {
+    double radius = size / 2;
+    long x0 = floor_long(p[0] - radius), x1 = ceil_long(p[0] + radius);
+    long y0 = floor_long(p[1] - radius), y1 = ceil_long(p[1] + radius);
+    for (long y = y0; y <= y1; y++)
+      for (long x = x0; x <= x1; x++) {
+        double dx = x + 0.5 - p[0], dy = y + 0.5 - p[1];
+        if (dx * dx + dy * dy <= radius * radius)
+          plot(target, x, y, p[2], color);
+      }
+  } else {
+    long side = lround(size) > 1 ? lround(size) : 1;
+    long x0, y0;
+    if (side % 2) {
+      x0 = floor_long(p[0]) - (side - 1) / 2;
+      y0 = floor_long(p[1]) - (side - 1) / 2;
+    } else {
+      x0 = floor_long(p[0] + 0.5) - side / 2;
+      y0 = floor_long(p[1] + 0.5) - side / 2;
+    }
+    for (long y = y0; y < y0 + side; y++)
+      for (long x = x0; x < x0 + side; x++)
+        plot(target, x, y, p[2], color);
+  }
+}
+
+/**
+ * @brief Converts a color from floating point to bytes
+ *
+ * @param rgb Red, green and blue from 0 to 1
+ * @param color Red, green, blue and alpha bytes, alpha is opaque
+ */
+static void color_bytes(const double *rgb, unsigned char *color) {
+  for (int k = 0; k < 3; k++) {
+    double value = rgb[k] < 0 ? 0 : rgb[k] > 1 ? 1 : rgb[k];
+    color[k] = (unsigned char)lround(value * 255);
+  }
+  color[3] = 255;
+}
+
+/**
+ * @brief Transforms one vertex into clip coordinates
+ *
+ * @param job Render job
+ * @param index Number of the vertex
+ * @param clip x, y, z and w
+ */
+static void vertex_clip(const render_job *job, size_t index, double *clip) {
+  double v[3];
+  get_vertex(job->data_obj, index, v);
+  for (int row = 0; row < 4; row++)
+    clip[row] = job->matrix[row] * v[0] + job->matrix[4 + row] * v[1] +
+                job->matrix[8 + row] * v[2] + job->matrix[12 + row];
+}
+
+/**
+ * @brief Returns the clipping planes a point lies outside of
+ *
+ * Uses the same tests as clip_segment(), bit 2 * axis for -w <= axis and
+ * bit 2 * axis + 1 for axis <= w.
+ *
+ * @param clip Clip coordinates
+ * @return Outcode, zero inside the view volume
+ */
+static unsigned char outcode(const double *clip) {
+  unsigned char code = 0;
+  for (int plane = 0; plane < 6; plane++)
+    if (clip[3] + (plane % 2 ? -1 : 1) * clip[plane / 2] < 0)
+      code |= 1 << plane;
+  return code;
+}
+
+/**
+ * @brief Finds the outcodes and window coordinates of one chunk of vertices
+ *
+ * Called by parallel_for(); the zero row is transformed too.
+ *
+ * @param context Pointer to the render_job
+ * @param index Number of the chunk
+ */
+static void transform_task(void *context, size_t index) {
+  render_job *job = context;
+  size_t end = (index + 1) * RENDER_CHUNK;
+  if (end > job->data_obj->vertex_count + 1)
+    end = job->data_obj->vertex_count + 1;
+  for (size_t i = index * RENDER_CHUNK; i < end; i++) {
+    double clip[4];
+    vertex_clip(job, i, clip);
+    job->outcodes[i] = outcode(clip);
+    if (job->outcodes[i] == 0)
+      to_window(job->settings, clip, job->window + i * 3);
+  }
+}
+
+/**
+ * @brief Projects one primitive to window coordinates
+ *
+ * @param job Render job
+ * @param primitive Number of the primitive
+ * @param p0 First end of a line, or the point
+ * @param p1 Second end of a line
+ * @return 1 if the primitive is visible, 0 otherwise
+ */
+static int project_primitive(const render_job *job, size_t primitive,
+                             double *p0, double *p1) {
+  int visible;
+  if (primitive < job->line_count) {
+    size_t a = job->lines[2 * primitive], b = job->lines[2 * primitive + 1];
+    int code_a = job->outcodes[a], code_b = job->outcodes[b];
+    visible = (code_a & code_b) == 0;
+    if (visible && (code_a | code_b) == 0) {
+      memcpy(p0, job->window + a * 3, 3 * sizeof(double));
+      memcpy(p1, job->window + b * 3, 3 * sizeof(double));
+    } else if (visible) {
+      double clip_a[4], clip_b[4];
+      vertex_clip(job, a, clip_a);
+      vertex_clip(job, b, clip_b);
+      visible = clip_segment(clip_a, clip_b);
+      if (visible) {
+        to_window(job->settings, clip_a, p0);
+        to_window(job->settings, clip_b, p1);
+      }
+    }
+  } else {
+    size_t vertex = primitive - job->line_count + 1;
+    visible = job->outcodes[vertex] == 0;
+    if (visible) memcpy(p0, job->window + vertex * 3, 3 * sizeof(double));
+  }
+  return visible;
+}
+
+/**
+ * @brief Finds the tiles a primitive may cover
+ *
+ * Uses the bounding box of the primitive widened by the line width or the
+ * point size and one pixel of margin.
+ *
+ * @param job Render job
+ * @param primitive Number of the primitive
+ * @param tiles First and last tile column, then first and last tile row
+ * @return 1 if the primitive covers at least one tile, 0 otherwise
+ */
+static int primitive_tiles(const render_job *job, size_t primitive,
+                           uint16_t *tiles) {
+  double p0[3], p1[3];
+  int visible = project_primitive(job, primitive, p0, p1);
+  if (visible) {
+    double margin = primitive < job->line_count
+                        ? job->line_width / 2.0 + 1
+                        : job->settings->size_points / 2 + 1;
+    if (primitive >= job->line_count) memcpy(p1, p0, sizeof(p1));
+    double box[4] = {(p0[0] < p1[0] ? p0[0] : p1[0]) - margin,
+                     (p0[0] < p1[0] ? p1[0] : p0[0]) + margin,
+                     (p0[1] < p1[1] ? p0[1] : p1[1]) - margin,
+                     (p0[1] < p1[1] ? p1[1] : p0[1]) + margin};
+    int limits[2] = {job->tiles_x - 1, job->tiles_y - 1};
+    for (int k = 0; k < 4; k++) {
+      int size = k < 2 ? job->tile_width : job->tile_height;
+      long tile = box[k] < 0 ? 0 : (long)(box[k] / size);
+      tiles[k] = tile > limits[k / 2] ? limits[k / 2] : (uint16_t)tile;
+    }
+    visible = box[1] >= 0 && box[3] >= 0 &&
+              box[0] < job->settings->width && box[2] < job->settings->height;
+  }
+  return visible;
+}
+
+/**
+ * @brief Finds the tiles and counts the bin entries of one chunk of primitives
+ *
+ * The tiles of a primitive that is not visible are stored as an empty range.
+ *
+ * @param context Pointer to the render_job
+ * @param index Number of the chunk
+ */
+static void count_task(void *context, size_t index) {
+  render_job *job = context;
+  size_t tile_count = (size_t)job->tiles_x * job->tiles_y;
+  size_t *counts = job->counts + index * tile_count;
+  size_t end = (index + 1) * RENDER_CHUNK;
+  if (end > job->line_count + job->point_count)
+    end = job->line_count + job->point_count;
+  for (size_t i = index * RENDER_CHUNK; i < end; i++) {
+    uint16_t *tiles = job->rects + i * 4;
+    if (primitive_tiles(job, i, tiles)) {
+      for (int y = tiles[2]; y <= tiles[3]; y++)
+        for (int x = tiles[0]; x <= tiles[1]; x++)
+          counts[(size_t)y * job->tiles_x + x]++;
+    } else {
+      tiles[0] = 1;
+      tiles[1] = 0;
+    }
+  }
+}
+
+/**
+ * @brief Writes the bin entries of one chunk of primitives
+ *
+ * The counts of the chunk have been turned into write positions by
+ * bin_primitives(), so chunks never write to the same place.
+ *
+ * @param context Pointer to the render_job
+ * @param index Number of the chunk
+ */
+static void bin_task(void *context, size_t index) {
+  render_job *job = context;
+  size_t tile_count = (size_t)job->tiles_x * job->tiles_y;
+  size_t *positions = job->counts + index * tile_count;
+  size_t end = (index + 1) * RENDER_CHUNK;
+  if (end > job->line_count + job->point_count)
+    end = job->line_count + job->point_count;
+  for (size_t i = index * RENDER_CHUNK; i < end; i++) {
+    const uint16_t *tiles = job->rects + i * 4;
+    for (int y = tiles[2]; y <= tiles[3] && tiles[0] <= tiles[1]; y++)
+      for (int x = tiles[0]; x <= tiles[1]; x++)
+        job->bins[positions[(size_t)y * job->tiles_x + x]++] = (uint32_t)i;
+  }
+}
+
+/**
+ * @brief Clears and rasterizes one tile
+ *
+ * @param context Pointer to the render_job
+ * @param index Number of the tile, row by row from the bottom left one
+ */
+static void tile_task(void *context, size_t index) {
+  render_job *job = context;
+  const render_settings *settings = job->settings;
+  float tile_depth[TILE_SIZE * TILE_SIZE];
+  int x0 = (int)(index % job->tiles_x) * job->tile_width;
+  int y0 = (int)(index / job->tiles_x) * job->tile_height;
+  raster_t target = {job->pixels,
+                     job->depth ? job->depth : tile_depth,
+                     settings->width,
+                     settings->height,
+                     x0,
+                     y0,
+                     x0 + job->tile_width < settings->width
+                         ? x0 + job->tile_width
+                         : settings->width,
+                     y0 + job->tile_height < settings->height
+                         ? y0 + job->tile_height
+                         : settings->height};
+  for (int y = target.y0; y < target.y1; y++) {
+    unsigned char *row =
+        job->pixels + (size_t)(settings->height - 1 - y) * settings->width * 4;
+    for (int x = target.x0; x < target.x1; x++)
+      memcpy(row + (size_t)x * 4, job->background, 4);
+  }
+  size_t area = (size_t)(target.x1 - target.x0) * (target.y1 - target.y0);
+  for (size_t i = 0; i < area; i++) target.depth[i] = 1;
+  int dashed = settings->type_line == 0;
+  size_t begin = job->bins ? job->bin_offsets[index] : 0;
+  size_t end = job->bins ? job->bin_offsets[index + 1]
+                         : job->line_count + job->point_count;
+  for (size_t i = begin; i < end; i++) {
+    size_t primitive = job->bins ? job->bins[i] : i;
+    double p0[3], p1[3];
+    if (project_primitive(job, primitive, p0, p1)) {
+      if (primitive < job->line_count)
+        draw_line(&target, p0, p1, job->line_width, dashed, job->line);
+      else
+        draw_point(&target, p0, settings->size_points,
+                   settings->type_point == 1, job->point);
+    }
+  }
+}
+
+/**
+ * @brief Sorts the primitives into the tiles they may cover
+ *
+ * Every chunk of primitives first counts its entries per tile; the counts
+ * are then turned into write positions so that the entries of a tile follow
+ * one another in the order of the primitives.
+ *
+ * @param job Render job with the vertices already transformed
+ * @param threads Number of threads, 0 for one per CPU core
+ * @return OK if successful, ERROR otherwise
+ */
+static int bin_primitives(render_job *job, int threads) {
+  size_t tile_count = (size_t)job->tiles_x * job->tiles_y;
+  size_t primitives = job->line_count + job->point_count;
+  size_t chunks = (primitives + RENDER_CHUNK - 1) / RENDER_CHUNK;
+  job->rects = malloc((primitives + 1) * 4 * sizeof(uint16_t));
+  job->counts = calloc(chunks * tile_count + 1, sizeof(size_t));
+  job->bin_offsets = malloc((tile_count + 1) * sizeof(size_t));
+  int status = job->rects && job->counts && job->bin_offsets ? OK : ERROR;
+  if (status == OK) {
+    parallel_for(chunks, threads, count_task, job);
+    size_t total = 0;
+    for (size_t t = 0; t < tile_count; t++) {
+      job->bin_offsets[t] = total;
+      for (size_t c = 0; c < chunks; c++) {
+        size_t count = job->counts[c * tile_count + t];
+        job->counts[c * tile_count + t] = total;
+        total += count;
+      }
+    }
+    job->bin_offsets[tile_count] = total;
+    job->bins = malloc((total + 1) * sizeof(uint32_t));
+    if (!job->bins) status = ERROR;
+  }
+  if (status == OK) parallel_for(chunks, threads, bin_task, job);
+  return status;
+}
+
+/**
+ * @brief Builds the line list of an object without one
+ *
+ * Every side of every polygon becomes a line, as a line loop would draw it.
+ *
+ * @param data_obj Pointer to the data_object struct
+ * @return Two vertex numbers per side to be freed by the caller, NULL on error
+ */
+static unsigned int *polygon_lines(const data_object *data_obj) {
+  unsigned int *lines =
+      malloc((data_obj->all_edges_count * 2 + 1) * sizeof(unsigned int));
+  if (lines) {
+    size_t count = 0;
+    for (size_t i = 0; i < data_obj->polygon_count; i++) {
+      polygon_t polygon = get_polygon(data_obj, i);
+      for (size_t j = 0; j < polygon.colums; j++) {
+        lines[count++] = polygon.polygon[j];
+        lines[count++] = polygon.polygon[(j + 1) % polygon.colums];
+      }
+    }
+  }
+  return lines;
+}
+
+/**
+ * @brief Renders an object into an RGBA buffer on the CPU
+ *
+ * The wireframe comes from the line list of build_edges(); without one, the
+ * polygons are drawn as line loops. Points are drawn over the lines for
+ * vertices 1 to vertex_count when settings->type_point is not zero. The work
+ * is spread over settings->threads threads, 0 for one per CPU core; the
+ * image is the same for any number of threads.
+ *
+ * @param data_obj Pointer to the data_object struct, may be empty
+ * @param settings Render settings
+ * @param pixels settings->width * settings->height * 4 bytes, filled with
+ * red, green, blue and alpha, the top row first
+ * @return OK if successful, ERROR otherwise
+ */
+int soft_render(const data_object *data_obj, const render_settings *settings,
+                unsigned char *pixels) {
+  int status = data_obj && settings && pixels && settings->width > 0 &&
+                       settings->height > 0 && settings->extent > 0
+                   ? OK
+                   : ERROR;
+  render_job job = {0};
+  unsigned int *polygon_list = NULL;
+  int threads = 0;
+  if (status == OK) {
+    threads = settings->threads > 0 ? settings->threads : parallel_threads();
+    // С одним потоком всё изображение рисуется как одна плитка
+    job.tile_width = threads > 1 ? TILE_SIZE : settings->width;
+    job.tile_height = threads > 1 ? TILE_SIZE : settings->height;
+    job.tiles_x = (settings->width + job.tile_width - 1) / job.tile_width;
+    job.tiles_y = (settings->height + job.tile_height - 1) / job.tile_height;
+    job.data_obj = data_obj;
+    job.settings = settings;
+    job.pixels = pixels;
+    if (data_obj->edge_array) {
+      job.lines = data_obj->edge_array;
+      job.line_count = data_obj->edges_count;
+    } else if (data_obj->polygon_count > 0) {
+      job.lines = polygon_list = polygon_lines(data_obj);
+      job.line_count = data_obj->all_edges_count;
+      if (!polygon_list) status = ERROR;
+    }
+    job.point_count = settings->type_point != 0 ? data_obj->vertex_count : 0;
+    if (job.line_count + job.point_count > UINT32_MAX ||
+        job.tiles_x > UINT16_MAX || job.tiles_y > UINT16_MAX)
+      status = ERROR;
+  }
+  if (status == OK) {
+    job.window = malloc((data_obj->vertex_count + 1) * 3 * sizeof(double));
+    job.outcodes = malloc(data_obj->vertex_count + 1);
+    if (threads == 1)
+      job.depth =
+          malloc((size_t)settings->width * settings->height * sizeof(float));
+    if (!job.window || !job.outcodes || (threads == 1 && !job.depth))
+      status = ERROR;
+  }
+  if (status == OK) {
+    color_bytes(settings->background_color, job.background);
+    color_bytes(settings->line_color, job.line);
+    color_bytes(settings->points_color, job.point);
+    job.line_width =
+        lround(settings->thickness) > 1 ? (int)lround(settings->thickness) : 1;
+    double projection[16], identity[16];
+    model_identity(identity);
+    projection_matrix(settings, projection);
+    matrix_multiply(projection,
+                    settings->model_matrix ? settings->model_matrix : identity,
+                    job.matrix);
+    parallel_for((data_obj->vertex_count + RENDER_CHUNK) / RENDER_CHUNK,
+                 threads, transform_task, &job);
+    if (threads > 1) status = bin_primitives(&job, threads);
+  }
+  if (status == OK)
+    parallel_for((size_t)job.tiles_x * job.tiles_y, threads, tile_task, &job);
+  free(job.window);
+  free(job.outcodes);
+  free(job.depth);
+  free(job.rects);
+  free(job.counts);
+  free(job.bin_offsets);
+  free(job.bins);
+  free(polygon_list);
+  return status;
+}
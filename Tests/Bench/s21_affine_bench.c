@@ -0,0 +1,119 @@
+#include "../../Core/3DViever.h"
+
+#include <time.h>
+
+#define BENCH_VERTICES 1000000
+#define BENCH_REPEATS 10
+
+static const char *level_names[] = {"scalar", "sse2", "avx2"};
+
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void fill_object(data_object *data_obj, size_t count) {
+  create_matrix(count + 1, 3, &data_obj->vertex_array);
+  data_obj->vertex_count = count;
+  for (size_t i = 3; i < (count + 1) * 3; i++)
+    data_obj->vertex_array.matrix[i] = (double)(i % 1000) / 500.0 - 1.0;
+}
+
+static void report(const char *layout, const char *kernel, size_t count,
+                   double seconds) {
+  printf("%-4s %-16s %8.1f Mvertices/s\n", layout, kernel,
+         count / seconds / 1e6);
+}
+
+static double time_soa(vertex_soa *soa, int kernel, const double *matrix) {
+  double best = 1e9;
+  for (int r = 0; r < BENCH_REPEATS; r++) {
+    double t = now();
+    if (kernel == 0) soa_move(soa, 0.01, -0.01, 0.02);
+    if (kernel == 1) soa_rotate_x(soa, 1);
+    if (kernel == 2) soa_scale(soa, r % 2 ? 0.5 : 2.0);
+    if (kernel == 3) soa_transform(soa, matrix);
+    t = now() - t;
+    if (t < best) best = t;
+  }
+  return best;
+}
+
+static double time_aos(data_object *data_obj, int kernel) {
+  double best = 1e9;
+  for (int r = 0; r < BENCH_REPEATS; r++) {
+    double t = now();
+    if (kernel == 0) {
+      move_x(data_obj, 0.01, 0);
+      move_y(data_obj, -0.01, 0);
+      move_z(data_obj, 0.02, 0);
+    }
+    if (kernel == 1) rotate_x(data_obj, 1, 0);
+    if (kernel == 2) scale(data_obj, r % 2 ? 1 : 2, r % 2 ? 2 : 1);
+    t = now() - t;
+    if (t < best) best = t;
+  }
+  return best;
+}
+
+static void bench_threads(data_object *data_obj) {
+  int cores = parallel_threads();
+  int counts[] = {1, 2, 4, 8, cores};
+  double serial = 0;
+  for (int i = 0; i < 5; i++) {
+    if (i == 4 && (cores == 1 || cores == 2 || cores == 4 || cores == 8))
+      continue;
+    affine_set_parallel(counts[i], 1);
+    double t = time_aos(data_obj, 1);
+    if (i == 0) serial = t;
+    char name[32];
+    snprintf(name, sizeof(name), "rotate/%d thr", counts[i]);
+    report("aos", name, data_obj->vertex_count, t);
+    printf("%-4s %-16s %8.2fx\n", "", "speedup", serial / t);
+  }
+  affine_set_parallel(0, 0);
+}
+
+int main(int argc, char **argv) {
+  static const char *kernel_names[] = {"move", "rotate", "scale",
+                                       "transform"};
+  data_object data_obj = {0};
+  int from_file = argc > 1 && strcmp(argv[1], "-n") != 0;
+  if (from_file) {
+    if (parser(argv[1], &data_obj) != OK) return 1;
+  } else
+    fill_object(&data_obj, argc > 2 ? strtoul(argv[2], NULL, 10)
+                                    : BENCH_VERTICES);
+  double matrix[16];
+  model_identity(matrix);
+  model_rotate_y(matrix, 1);
+  model_move(matrix, 0.01, 0, 0);
+  printf("%zu vertices, best of %d runs\n", data_obj.vertex_count,
+         BENCH_REPEATS);
+  printf("%d CPU cores\n", parallel_threads());
+  affine_set_parallel(1, 0);
+  for (int kernel = 0; kernel < 3; kernel++)
+    report("aos", kernel_names[kernel], data_obj.vertex_count,
+           time_aos(&data_obj, kernel));
+  bench_threads(&data_obj);
+  int best = simd_set_level(SIMD_AVX2);
+  vertex_soa soa;
+  if (soa_load(&data_obj, &soa) != OK) return 1;
+  for (int level = SIMD_SCALAR; level <= best; level++) {
+    simd_set_level(level);
+    for (int kernel = 0; kernel < 4; kernel++) {
+      char name[32];
+      snprintf(name, sizeof(name), "%s/%s", level_names[level],
+               kernel_names[kernel]);
+      report("soa", name, soa.count, time_soa(&soa, kernel, matrix));
+    }
+  }
+  if (from_file)
+    memory_free(&data_obj);
+  else {
+    memory_free_matrix(&data_obj.vertex_array);
+    arena_release(&data_obj.arena);
+  }
+  return 0;
+}
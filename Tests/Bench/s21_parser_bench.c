@@ -0,0 +1,100 @@
+#include "../../Core/3DViever.h"
+
+#include <time.h>
+
+#define BENCH_GRID 1200
+#define BENCH_REPEATS 3
+
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static int write_grid(const char *file_name, int grid) {
+  FILE *file = fopen(file_name, "w");
+  if (!file) return ERROR;
+  for (int y = 0; y <= grid; y++)
+    for (int x = 0; x <= grid; x++)
+      fprintf(file, "v %.6f %.6f %.6f\n", (double)x / grid - 0.5,
+              (double)y / grid - 0.5, 0.1 * sin(x * 0.05) * cos(y * 0.05));
+  for (int y = 0; y < grid; y++)
+    for (int x = 0; x < grid; x++) {
+      int v = y * (grid + 1) + x + 1;
+      fprintf(file, "f %d %d %d\nf %d %d %d\n", v, v + 1, v + grid + 2, v,
+              v + grid + 2, v + grid + 1);
+    }
+  fclose(file);
+  return OK;
+}
+
+static unsigned long long hash_bytes(unsigned long long hash,
+                                     const void *data, size_t size) {
+  const unsigned char *bytes = data;
+  for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  return hash;
+}
+
+static unsigned long long model_hash(const data_object *data_obj) {
+  const matrix_t *vertices = &data_obj->vertex_array;
+  unsigned long long hash =
+      hash_bytes(1469598103934665603ULL, vertices->matrix,
+                 vertices->rows * vertices->colums * sizeof(*vertices->matrix));
+  hash = hash_bytes(hash, data_obj->offset_array,
+                    (data_obj->polygon_count + 1) * sizeof(size_t));
+  return hash_bytes(hash, data_obj->index_array,
+                    data_obj->all_edges_count * sizeof(unsigned int));
+}
+
+static double time_parse(char *file_name, int threads, data_object *data_obj) {
+  parser_options options = {0};
+  options.read_mode = READ_MMAP;
+  options.threads = threads;
+  double best = 1e9;
+  for (int r = 0; r < BENCH_REPEATS; r++) {
+    memory_free(data_obj);
+    double t = now();
+    if (parse_obj(file_name, data_obj, &options) != OK) return -1;
+    t = now() - t;
+    if (t < best) best = t;
+  }
+  return best;
+}
+
+int main(int argc, char **argv) {
+  char *grid_name = "parser_bench_grid.obj";
+  int from_file = argc > 1;
+  char *file_name = from_file ? argv[1] : grid_name;
+  if (!from_file && write_grid(grid_name, BENCH_GRID) != OK) return 1;
+  FILE *file = fopen(file_name, "rb");
+  long size = 0;
+  if (file && fseek(file, 0, SEEK_END) == 0) size = ftell(file);
+  if (file) fclose(file);
+  data_object data_obj = {0};
+  int counts[] = {1, 2, 4, 8, 16};
+  double serial = 0;
+  unsigned long long serial_hash = 0;
+  int status = 0;
+  printf("%.1f MB, best of %d runs, %d CPU cores\n", size / 1e6,
+         BENCH_REPEATS, parallel_threads());
+  for (int i = 0; status == 0 && i < 5; i++) {
+    double t = time_parse(file_name, counts[i], &data_obj);
+    if (t < 0) {
+      status = 1;
+    } else {
+      unsigned long long hash = model_hash(&data_obj);
+      if (i == 0) {
+        serial = t;
+        serial_hash = hash;
+        printf("%zu vertices, %zu polygons\n", data_obj.vertex_count,
+               data_obj.polygon_count);
+      }
+      printf("threads %2d %8.3f s %8.1f MB/s %6.2fx%s\n", counts[i], t,
+             size / t / 1e6, serial / t,
+             hash == serial_hash ? "" : "  model differs");
+    }
+  }
+  memory_free(&data_obj);
+  if (!from_file) remove(grid_name);
+  return status;
+}
@@ -0,0 +1,87 @@
+#include "../../Core/3DViever.h"
+
+#include <time.h>
+
+#define BENCH_GRID 1000
+#define BENCH_REPEATS 5
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 720
+
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static int write_grid(const char *file_name, int grid) {
+  FILE *file = fopen(file_name, "w");
+  if (!file) return ERROR;
+  for (int y = 0; y <= grid; y++)
+    for (int x = 0; x <= grid; x++)
+      fprintf(file, "v %g %g %g\n", (double)x / grid - 0.5,
+              (double)y / grid - 0.5,
+              0.1 * sin(x * 0.05) * cos(y * 0.05));
+  for (int y = 0; y < grid; y++)
+    for (int x = 0; x < grid; x++) {
+      int v = y * (grid + 1) + x + 1;
+      fprintf(file, "f %d %d %d %d\n", v, v + 1, v + grid + 2, v + grid + 1);
+    }
+  fclose(file);
+  return OK;
+}
+
+static double time_render(const data_object *data_obj,
+                          const render_settings *settings,
+                          unsigned char *pixels) {
+  double best = 1e9;
+  for (int r = 0; r < BENCH_REPEATS; r++) {
+    double t = now();
+    soft_render(data_obj, settings, pixels);
+    t = now() - t;
+    if (t < best) best = t;
+  }
+  return best;
+}
+
+int main(int argc, char **argv) {
+  const char *grid_name = "render_bench_grid.obj";
+  int from_file = argc > 1;
+  data_object data_obj = {0};
+  if (!from_file && write_grid(grid_name, BENCH_GRID) != OK) return 1;
+  if (parser(from_file ? argv[1] : (char *)grid_name, &data_obj) != OK ||
+      build_edges(&data_obj) != OK)
+    return 1;
+  if (!from_file) remove(grid_name);
+  double matrix[16];
+  model_identity(matrix);
+  model_rotate_x(matrix, -60);
+  model_rotate_z(matrix, 30);
+  render_settings settings = {BENCH_WIDTH, BENCH_HEIGHT, 1,         1, 2, 1, 3,
+                              {1, 1, 0},   {0, 0, 1},    {0, 0, 0}, matrix};
+  settings.extent = model_extent(&data_obj);
+  size_t size = (size_t)BENCH_WIDTH * BENCH_HEIGHT * 4;
+  unsigned char *reference = malloc(size), *pixels = malloc(size);
+  if (!reference || !pixels) return 1;
+  printf("%zu vertices, %zu edges, %dx%d, best of %d runs\n",
+         data_obj.vertex_count, data_obj.edges_count, BENCH_WIDTH,
+         BENCH_HEIGHT, BENCH_REPEATS);
+  printf("%d CPU cores\n", parallel_threads());
+  int cores = parallel_threads();
+  int counts[] = {1, 2, 4, 8, cores};
+  double serial = 0;
+  for (int i = 0; i < 5; i++) {
+    if (i == 4 && (cores == 1 || cores == 2 || cores == 4 || cores == 8))
+      continue;
+    settings.threads = counts[i];
+    double t = time_render(&data_obj, &settings, i == 0 ? reference : pixels);
+    if (i == 0) serial = t;
+    int same = i == 0 || memcmp(reference, pixels, size) == 0;
+    printf("%2d thr %8.1f ms %8.1f Medges/s %6.2fx%s\n", counts[i], t * 1e3,
+           data_obj.edges_count / t / 1e6, serial / t,
+           same ? "" : "  image differs");
+  }
+  free(reference);
+  free(pixels);
+  memory_free(&data_obj);
+  return 0;
+}
@@ -0,0 +1,135 @@
+#include "../../Core/3DViever.h"
+
+#include <time.h>
+
+#define BENCH_TOKENS 2000000
+#define BENCH_REPEATS 3
+
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static char *make_floats(size_t count, size_t *size) {
+  char *text = malloc(count * 24 + 1);
+  size_t len = 0;
+  srand(21);
+  for (size_t i = 0; text && i < count; i++) {
+    double value = (rand() / (double)RAND_MAX - 0.5) * 200.0;
+    len += sprintf(text + len, i % 16 ? "%.6f " : "%.6e ", value);
+  }
+  *size = len;
+  return text;
+}
+
+static char *make_faces(size_t count, size_t *size) {
+  char *text = malloc(count * 24 + 1);
+  size_t len = 0;
+  srand(21);
+  for (size_t i = 0; text && i < count; i++)
+    len += sprintf(text + len, "%d/%d/%d ", rand() % 1000000 + 1,
+                   rand() % 1000000 + 1, rand() % 1000000 + 1);
+  *size = len;
+  return text;
+}
+
+static void run_scan_double(const char *text, size_t size, double *sum) {
+  const char *pos = text, *end = text + size;
+  double value = 0;
+  while (scan_double(&pos, end, &value) == OK) *sum += value;
+}
+
+static void run_strtod(const char *text, size_t size, double *sum) {
+  const char *pos = text, *end = text + size;
+  char *next = NULL;
+  while (pos < end) {
+    *sum += strtod(pos, &next);
+    if (next == pos) break;
+    pos = next;
+  }
+}
+
+// sscanf() measures the length of its input, so every token ends with '\0'
+static char *split_tokens(const char *text, size_t size) {
+  char *split = malloc(size + 1);
+  for (size_t i = 0; split && i <= size; i++)
+    split[i] = i < size && text[i] != ' ' ? text[i] : '\0';
+  return split;
+}
+
+static void run_sscanf_double(const char *text, size_t size, double *sum) {
+  const char *pos = text, *end = text + size;
+  double value = 0;
+  int read = 0;
+  while (pos < end && sscanf(pos, "%lf%n", &value, &read) == 1) {
+    *sum += value;
+    pos += read + 1;
+  }
+}
+
+static void run_scan_face(const char *text, size_t size, double *sum) {
+  const char *pos = text, *end = text + size;
+  long v = 0, vt = 0, vn = 0;
+  while (scan_face_vertex(&pos, end, &v, &vt, &vn) == OK && v != 0)
+    *sum += v + vt + vn;
+}
+
+static void run_strtol_face(const char *text, size_t size, double *sum) {
+  const char *pos = text, *end = text + size;
+  char *next = NULL;
+  while (pos < end) {
+    long value = strtol(pos, &next, 10);
+    if (next == pos) break;
+    *sum += value;
+    pos = *next == '/' ? next + 1 : next;
+  }
+}
+
+static void run_sscanf_face(const char *text, size_t size, double *sum) {
+  const char *pos = text, *end = text + size;
+  long v = 0, vt = 0, vn = 0;
+  int read = 0;
+  while (pos < end &&
+         sscanf(pos, "%ld/%ld/%ld%n", &v, &vt, &vn, &read) == 3) {
+    *sum += v + vt + vn;
+    pos += read + 1;
+  }
+}
+
+static void report(const char *name, const char *text, size_t size,
+                   void (*run)(const char *, size_t, double *)) {
+  double best = 1e9, sum = 0;
+  for (int r = 0; r < BENCH_REPEATS; r++) {
+    sum = 0;
+    double t = now();
+    run(text, size, &sum);
+    t = now() - t;
+    if (t < best) best = t;
+  }
+  printf("%-18s %8.1f MB/s  checksum %.6g\n", name, size / best / 1e6, sum);
+}
+
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : BENCH_TOKENS;
+  size_t float_size = 0, face_size = 0;
+  char *floats = make_floats(count, &float_size);
+  char *faces = make_faces(count, &face_size);
+  char *split_floats = floats ? split_tokens(floats, float_size) : NULL;
+  char *split_faces = faces ? split_tokens(faces, face_size) : NULL;
+  if (!split_floats || !split_faces) return 1;
+  printf("%zu tokens, best of %d runs\n", count, BENCH_REPEATS);
+  printf("floats, %.1f MB\n", float_size / 1e6);
+  report("scan_double", floats, float_size, run_scan_double);
+  report("strtod", floats, float_size, run_strtod);
+  report("sscanf %lf", split_floats, float_size, run_sscanf_double);
+  printf("v/vt/vn, %.1f MB\n", face_size / 1e6);
+  report("scan_face_vertex", faces, face_size, run_scan_face);
+  report("strtol", faces, face_size, run_strtol_face);
+  report("sscanf %ld/%ld/%ld", split_faces, face_size, run_sscanf_face);
+  free(floats);
+  free(faces);
+  free(split_floats);
+  free(split_faces);
+  return 0;
+}
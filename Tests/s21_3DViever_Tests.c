@@ -21,7 +21,10 @@ void run_tests(void) {
   Suite *list_cases[] = {
       s21_parser_Tests(),   s21_move_x_Tests(),   s21_move_y_Tests(),
       s21_move_z_Tests(),   s21_rotate_x_Tests(), s21_rotate_y_Tests(),
-      s21_rotate_z_Tests(), s21_scale_Tests(),    NULL};
+      s21_rotate_z_Tests(), s21_scale_Tests(),    s21_scanner_Tests(),
+      s21_arena_Tests(),    s21_cache_Tests(),    s21_model_Tests(),
+      s21_simd_Tests(),     s21_quantize_Tests(), s21_edges_Tests(),
+      s21_softrender_Tests(), NULL};
   int number_failed = 0;
   int number_success = 0;
   for (Suite **current_testcase = list_cases; *current_testcase != NULL;
@@ -18,6 +18,15 @@ Suite *s21_rotate_y_Tests();
 Suite *s21_rotate_z_Tests();
 
 Suite *s21_scale_Tests();
+Suite *s21_model_Tests();
+Suite *s21_simd_Tests();
+Suite *s21_scanner_Tests();
+Suite *s21_arena_Tests();
+Suite *s21_cache_Tests();
+Suite *s21_quantize_Tests();
+Suite *s21_edges_Tests();
+Suite *s21_softrender_Tests();
+
 data_object *initialize_data_object(size_t vertex_count);
 void free_data_object(data_object *data_obj);
 #endif
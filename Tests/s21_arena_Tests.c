@@ -0,0 +1,69 @@
+#include <stdint.h>
+
+#include "s21_3DViever_Tests.h"
+
+START_TEST(test_arena_alloc) {
+  arena_t arena = {0};
+  char *a = arena_alloc(&arena, 10);
+  char *b = arena_alloc(&arena, 100);
+  ck_assert_ptr_nonnull(a);
+  ck_assert_ptr_nonnull(b);
+  ck_assert_int_eq((uintptr_t)a % 64, 0);
+  ck_assert_int_eq((uintptr_t)b % 64, 0);
+  ck_assert(b >= a + 10);
+  memset(a, 1, 10);
+  memset(b, 2, 100);
+  ck_assert_int_eq(a[9], 1);
+  ck_assert_int_eq(arena.used, 64 + 128);
+  ck_assert(arena.reserved >= arena.used);
+  ck_assert_int_eq(arena.high_water, arena.used);
+  arena_release(&arena);
+  ck_assert_ptr_null(arena.blocks);
+  ck_assert_int_eq(arena.reserved, 0);
+}
+END_TEST
+
+START_TEST(test_arena_reset) {
+  arena_t arena = {0};
+  char *first = arena_alloc(&arena, 4 << 20);
+  arena_alloc(&arena, 100);
+  size_t high_water = arena.used;
+  arena_reset(&arena);
+  ck_assert_int_eq(arena.used, 0);
+  ck_assert_int_eq(arena.high_water, high_water);
+  ck_assert_ptr_eq(arena_alloc(&arena, 1 << 20), first);
+  ck_assert_int_eq(arena.high_water, high_water);
+  arena_release(&arena);
+}
+END_TEST
+
+START_TEST(test_arena_reload) {
+  data_object data_obj = {0};
+  ck_assert_int_eq(parser("../Obj/cube.obj", &data_obj), OK);
+  vertex_t *vertices = data_obj.vertex_array.matrix;
+  size_t reserved = data_obj.arena.reserved;
+  ck_assert(data_obj.arena.used > 0);
+  memory_reset(&data_obj);
+  ck_assert_int_eq(data_obj.vertex_count, 0);
+  ck_assert_ptr_null(data_obj.vertex_array.matrix);
+  ck_assert_int_eq(data_obj.arena.used, 0);
+  ck_assert_int_eq(parser("../Obj/cube.obj", &data_obj), OK);
+  ck_assert_ptr_eq(data_obj.vertex_array.matrix, vertices);
+  ck_assert_int_eq(data_obj.arena.reserved, reserved);
+  ck_assert_int_eq(parser("../Obj/no_exist_file.obj", &data_obj), ERROR);
+  ck_assert_ptr_eq(data_obj.vertex_array.matrix, vertices);
+  memory_free(&data_obj);
+  ck_assert_ptr_null(data_obj.arena.blocks);
+}
+END_TEST
+
+Suite *s21_arena_Tests() {
+  Suite *s = suite_create("\033[42m-=s21_arena test=-\033[0m");
+  TCase *t = tcase_create("main tcase");
+  tcase_add_test(t, test_arena_alloc);
+  tcase_add_test(t, test_arena_reset);
+  tcase_add_test(t, test_arena_reload);
+
+  suite_add_tcase(s, t);
+  return s;
+}
@@ -0,0 +1,161 @@
+#include "s21_3DViever_Tests.h"
+
+#define CACHE_TEST_DIR "cache_test_dir"
+
+static void write_model(const char *file_name, const char *text) {
+  FILE *file = fopen(file_name, "w");
+  fputs(text, file);
+  fclose(file);
+}
+
+static int cache_is_empty(void) {
+  return system("test $(ls " CACHE_TEST_DIR " | wc -l) -eq 0") == 0;
+}
+
+static void remove_cache(void) {
+  if (system("rm -rf " CACHE_TEST_DIR) != 0) printf("rm failed\n");
+}
+
+START_TEST(test_load_obj_cache) {
+  remove_cache();
+  parser_options options = {0};
+  options.cache_dir = CACHE_TEST_DIR;
+  data_object parsed = {0}, cold = {0}, warm = {0};
+  int from_cache = -1;
+  ck_assert_int_eq(parser("../Obj/cube.obj", &parsed), OK);
+  ck_assert_int_eq(load_obj("../Obj/cube.obj", &cold, &options, &from_cache),
+                   OK);
+  ck_assert_int_eq(from_cache, 0);
+  ck_assert(!cache_is_empty());
+  ck_assert_int_eq(load_obj("../Obj/cube.obj", &warm, &options, &from_cache),
+                   OK);
+  ck_assert_int_eq(from_cache, 1);
+  ck_assert_ptr_nonnull(warm.mapping);
+  ck_assert_int_eq(warm.vertex_count, parsed.vertex_count);
+  ck_assert_int_eq(warm.polygon_count, parsed.polygon_count);
+  ck_assert_int_eq(warm.all_edges_count, parsed.all_edges_count);
+  ck_assert_int_eq(memcmp(warm.vertex_array.matrix, parsed.vertex_array.matrix,
+                          (parsed.vertex_count + 1) * 3 * sizeof(vertex_t)),
+                   0);
+  ck_assert_int_eq(memcmp(warm.offset_array, parsed.offset_array,
+                          (parsed.polygon_count + 1) * sizeof(size_t)),
+                   0);
+  ck_assert_int_eq(memcmp(warm.index_array, parsed.index_array,
+                          parsed.all_edges_count * sizeof(unsigned int)),
+                   0);
+  for (int i = 0; i < 3; i++) {
+    ck_assert_double_eq(warm.bbox_min[i], parsed.bbox_min[i]);
+    ck_assert_double_eq(warm.bbox_max[i], parsed.bbox_max[i]);
+    ck_assert_double_eq(warm.centroid[i], parsed.centroid[i]);
+  }
+  move_x(&warm, 5.0, 0.0);
+  ck_assert_int_eq(load_obj("../Obj/cube.obj", &cold, &options, &from_cache),
+                   OK);
+  ck_assert_int_eq(from_cache, 1);
+  ck_assert_double_eq(cold.vertex_array.matrix[3],
+                      parsed.vertex_array.matrix[3]);
+  memory_free(&parsed);
+  memory_free(&cold);
+  memory_free(&warm);
+  ck_assert_ptr_null(warm.mapping);
+  remove_cache();
+}
+END_TEST
+
+START_TEST(test_load_obj_stale_cache) {
+  remove_cache();
+  char *file_name = "cache_model.obj";
+  parser_options options = {0};
+  options.cache_dir = CACHE_TEST_DIR;
+  data_object data_obj = {0};
+  int from_cache = -1;
+  write_model(file_name, "v 1 2 3\nv 4 5 6\nv 7 8 9\nf 1 2 3\n");
+  ck_assert_int_eq(load_obj(file_name, &data_obj, &options, &from_cache), OK);
+  ck_assert_int_eq(from_cache, 0);
+  write_model(file_name, "v 1 2 3\nv 4 5 6\nv 7 8 9\nv 1 1 1\nf 1 2 4\n");
+  ck_assert_int_eq(load_obj(file_name, &data_obj, &options, &from_cache), OK);
+  ck_assert_int_eq(from_cache, 0);
+  ck_assert_int_eq(data_obj.vertex_count, 4);
+  ck_assert_int_eq(get_polygon(&data_obj, 0).polygon[2], 4);
+  ck_assert_int_eq(load_obj(file_name, &data_obj, &options, &from_cache), OK);
+  ck_assert_int_eq(from_cache, 1);
+  ck_assert_int_eq(data_obj.vertex_count, 4);
+  options.cache = CACHE_OFF;
+  ck_assert_int_eq(load_obj(file_name, &data_obj, &options, &from_cache), OK);
+  ck_assert_int_eq(from_cache, 0);
+  ck_assert_ptr_null(data_obj.mapping);
+  memory_free(&data_obj);
+  remove(file_name);
+  remove_cache();
+}
+END_TEST
+
+START_TEST(test_load_obj_corrupt_cache) {
+  remove_cache();
+  parser_options options = {0};
+  options.cache_dir = CACHE_TEST_DIR;
+  data_object data_obj = {0};
+  int from_cache = -1;
+  ck_assert_int_eq(
+      load_obj("../Obj/cube.obj", &data_obj, &options, &from_cache), OK);
+  ck_assert_int_eq(system("for f in " CACHE_TEST_DIR "/*; do truncate -s -4 "
+                          "$f; done"),
+                   0);
+  ck_assert_int_eq(
+      load_obj("../Obj/cube.obj", &data_obj, &options, &from_cache), OK);
+  ck_assert_int_eq(from_cache, 0);
+  ck_assert_int_eq(load_obj("../Obj/no_exist_file.obj", &data_obj, &options,
+                            &from_cache),
+                   ERROR);
+  memory_free(&data_obj);
+  remove_cache();
+}
+END_TEST
+
+typedef struct cache_race {
+  data_object models[8];
+  int status[8];
+  parser_options options;
+} cache_race;
+
+static void load_racing(void *context, size_t index) {
+  cache_race *race = context;
+  race->status[index] = load_obj("../Obj/ball.obj", &race->models[index],
+                                 &race->options, NULL);
+}
+
+START_TEST(test_load_obj_concurrent_cache) {
+  remove_cache();
+  cache_race race = {0};
+  race.options.cache_dir = CACHE_TEST_DIR;
+  race.options.threads = 1;
+  parallel_for(8, 8, load_racing, &race);
+  size_t vertex_count = race.models[0].vertex_count;
+  ck_assert_int_gt(vertex_count, 0);
+  for (int i = 0; i < 8; i++) {
+    ck_assert_int_eq(race.status[i], OK);
+    ck_assert_int_eq(race.models[i].vertex_count, vertex_count);
+    memory_free(&race.models[i]);
+  }
+  ck_assert_int_eq(system("test $(ls -A " CACHE_TEST_DIR " | wc -l) -eq 1"), 0);
+  data_object data_obj = {0};
+  int from_cache = -1;
+  ck_assert_int_eq(
+      load_obj("../Obj/ball.obj", &data_obj, &race.options, &from_cache), OK);
+  ck_assert_int_eq(from_cache, 1);
+  memory_free(&data_obj);
+  remove_cache();
+}
+END_TEST
+
+Suite *s21_cache_Tests() {
+  Suite *s = suite_create("\033[42m-=s21_cache test=-\033[0m");
+  TCase *t = tcase_create("main tcase");
+  tcase_add_test(t, test_load_obj_cache);
+  tcase_add_test(t, test_load_obj_stale_cache);
+  tcase_add_test(t, test_load_obj_corrupt_cache);
+  tcase_add_test(t, test_load_obj_concurrent_cache);
+
+  suite_add_tcase(s, t);
+  return s;
+}
@@ -0,0 +1,71 @@
+#include "s21_3DViever_Tests.h"
+
+static int has_edge(const data_object *data_obj, unsigned int a,
+                    unsigned int b) {
+  int found = 0;
+  for (size_t i = 0; i < data_obj->edges_count; i++) {
+    const unsigned int *edge = data_obj->edge_array + 2 * i;
+    if ((edge[0] == a && edge[1] == b) || (edge[0] == b && edge[1] == a))
+      found++;
+  }
+  return found;
+}
+
+START_TEST(test_build_edges) {
+  data_object data_obj = {0};
+  const char *file_name = "edges_model.obj";
+  FILE *file = fopen(file_name, "w");
+  fputs("v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+        "f 1 2 3 4\nf 1 3\nf 2\nf 3 2 1\nf 4 4 1\n",
+        file);
+  fclose(file);
+  ck_assert_int_eq(parser((char *)file_name, &data_obj), OK);
+  ck_assert_ptr_null(data_obj.edge_array);
+  ck_assert_int_eq(build_edges(&data_obj), OK);
+  ck_assert_int_eq(data_obj.edges_count, 5);
+  unsigned int expected[] = {1, 2, 2, 3, 3, 4, 1, 4, 1, 3};
+  ck_assert_int_eq(memcmp(data_obj.edge_array, expected, sizeof(expected)),
+                   0);
+  ck_assert_int_eq(build_edges(NULL), ERROR);
+  memory_free(&data_obj);
+  remove(file_name);
+}
+END_TEST
+
+START_TEST(test_build_edges_model) {
+  data_object data_obj = {0};
+  ck_assert_int_eq(parser("../Obj/cube.obj", &data_obj), OK);
+  ck_assert_int_eq(build_edges(&data_obj), OK);
+  ck_assert_int_eq(data_obj.edges_count, 18);
+  for (size_t i = 0; i < data_obj.polygon_count; i++) {
+    polygon_t polygon = get_polygon(&data_obj, i);
+    for (size_t j = 0; j < polygon.colums; j++)
+      ck_assert_int_eq(
+          has_edge(&data_obj, polygon.polygon[j],
+                   polygon.polygon[(j + 1) % polygon.colums]),
+          1);
+  }
+  for (size_t i = 0; i < data_obj.edges_count; i++)
+    ck_assert_int_lt(data_obj.edge_array[2 * i],
+                     data_obj.edge_array[2 * i + 1]);
+  ck_assert_int_eq(quantize_object(&data_obj), OK);
+  ck_assert_int_eq(data_obj.edges_count, 18);
+  ck_assert_int_eq(has_edge(&data_obj, get_polygon(&data_obj, 0).polygon[0],
+                            get_polygon(&data_obj, 0).polygon[1]),
+                   1);
+  ck_assert_int_eq(parser("../Obj/cube.obj", &data_obj), OK);
+  ck_assert_ptr_null(data_obj.edge_array);
+  ck_assert_int_eq(data_obj.edges_count, 0);
+  memory_free(&data_obj);
+}
+END_TEST
+
+Suite *s21_edges_Tests() {
+  Suite *s = suite_create("\033[42m-=s21_edges test=-\033[0m");
+  TCase *t = tcase_create("main tcase");
+  tcase_add_test(t, test_build_edges);
+  tcase_add_test(t, test_build_edges_model);
+
+  suite_add_tcase(s, t);
+  return s;
+}
@@ -61,7 +61,7 @@ data_object *initialize_data_object(size_t vertex_count) {
   data_object *data_obj = malloc(sizeof(data_object));
   data_obj->vertex_count = vertex_count;
   data_obj->vertex_array.matrix =
-      malloc((vertex_count + 1) * 3 * sizeof(double));
+      malloc((vertex_count + 1) * 3 * sizeof(vertex_t));
 
   for (size_t i = 0; i < vertex_count + 1; i++) {
     data_obj->vertex_array.matrix[i * 3] = (double)i;
@@ -179,6 +179,192 @@ START_TEST(parser_matrix_creation_error_test) {
 }
 END_TEST
 
+START_TEST(parse_obj_read_modes_test) {
+  data_object mapped = {0}, buffered = {0};
+  parser_options options = {READ_MMAP};
+  ck_assert_int_eq(parse_obj("../Obj/cube.obj", &mapped, &options), OK);
+  options.read_mode = READ_BUFFERED;
+  ck_assert_int_eq(parse_obj("../Obj/cube.obj", &buffered, &options), OK);
+  ck_assert_int_eq(mapped.vertex_count, buffered.vertex_count);
+  ck_assert_int_eq(mapped.polygon_count, buffered.polygon_count);
+  ck_assert_int_eq(mapped.all_edges_count, buffered.all_edges_count);
+  for (size_t i = 0; i < (mapped.vertex_count + 1) * 3; i++)
+    ck_assert_double_eq(mapped.vertex_array.matrix[i],
+                        buffered.vertex_array.matrix[i]);
+  for (size_t i = 0; i < mapped.polygon_count; i++) {
+    polygon_t a = get_polygon(&mapped, i), b = get_polygon(&buffered, i);
+    ck_assert_int_eq(a.colums, b.colums);
+    for (size_t j = 0; j < a.colums; j++)
+      ck_assert_int_eq(a.polygon[j], b.polygon[j]);
+  }
+  memory_free(&mapped);
+  memory_free(&buffered);
+}
+END_TEST
+
+START_TEST(parser_no_trailing_newline_test) {
+  char *file_name = "no_newline.obj";
+  FILE *file = fopen(file_name, "w");
+  fprintf(file, "v 1 2 3\nv 4 5 6\nv 7 8 9\nf 1 2 -1");
+  fclose(file);
+  data_object data_obj = {0};
+  ck_assert_int_eq(parser(file_name, &data_obj), OK);
+  ck_assert_int_eq(data_obj.vertex_count, 3);
+  ck_assert_int_eq(data_obj.polygon_count, 1);
+  ck_assert_int_eq(get_polygon(&data_obj, 0).colums, 3);
+  ck_assert_int_eq(get_polygon(&data_obj, 0).polygon[2], 3);
+  ck_assert_double_eq(data_obj.vertex_array.matrix[9], 7.0);
+  memory_free(&data_obj);
+  remove(file_name);
+}
+END_TEST
+
+START_TEST(parse_obj_threads_test) {
+  char *file_name = "threads.obj";
+  FILE *file = fopen(file_name, "w");
+  for (int i = 0; i < 60000; i++) {
+    fprintf(file, "v %d.25 %d.5 -%d.75\n", i, i % 97, i % 13);
+    if (i > 3) fprintf(file, "f -1 -2/1 -4//2 %d\n", i / 2 + 1);
+  }
+  fclose(file);
+  data_object serial = {0}, threaded = {0};
+  parser_options options = {READ_MMAP, 1};
+  ck_assert_int_eq(parse_obj(file_name, &serial, &options), OK);
+  options.threads = 4;
+  ck_assert_int_eq(parse_obj(file_name, &threaded, &options), OK);
+  ck_assert_int_eq(serial.vertex_count, 60000);
+  ck_assert_int_eq(serial.vertex_count, threaded.vertex_count);
+  ck_assert_int_eq(serial.polygon_count, threaded.polygon_count);
+  ck_assert_int_eq(serial.all_edges_count, threaded.all_edges_count);
+  ck_assert_int_eq(memcmp(serial.vertex_array.matrix,
+                          threaded.vertex_array.matrix,
+                          (serial.vertex_count + 1) * 3 * sizeof(vertex_t)),
+                   0);
+  ck_assert_int_eq(memcmp(serial.offset_array, threaded.offset_array,
+                          (serial.polygon_count + 1) * sizeof(size_t)),
+                   0);
+  ck_assert_int_eq(memcmp(serial.index_array, threaded.index_array,
+                          serial.all_edges_count * sizeof(unsigned int)),
+                   0);
+  for (int i = 0; i < 3; i++) {
+    ck_assert_double_eq(serial.bbox_min[i], threaded.bbox_min[i]);
+    ck_assert_double_eq(serial.bbox_max[i], threaded.bbox_max[i]);
+    ck_assert_double_eq_tol(serial.centroid[i], threaded.centroid[i], 1e-9);
+  }
+  ck_assert_double_eq(serial.bbox_min[0], 0.25);
+  ck_assert_double_eq(serial.bbox_max[0], 59999.25);
+  ck_assert_double_eq(serial.bbox_max[1], 96.5);
+  ck_assert_double_eq(serial.bbox_min[2], -12.75);
+  memory_free(&serial);
+  memory_free(&threaded);
+  remove(file_name);
+}
+END_TEST
+
+typedef struct progress_log {
+  int calls;
+  size_t last_done;
+  size_t total;
+  int cancel_after;
+} progress_log;
+
+static int log_progress(void *context, size_t done, size_t total) {
+  progress_log *log = context;
+  log->calls++;
+  if (done > log->last_done) log->last_done = done;
+  log->total = total;
+  return log->cancel_after > 0 && log->calls >= log->cancel_after;
+}
+
+START_TEST(parse_obj_progress_test) {
+  char *file_name = "progress.obj";
+  FILE *file = fopen(file_name, "w");
+  for (int i = 0; i < 100000; i++) {
+    fprintf(file, "v %d.25 %d.5 -%d.75\n", i, i % 97, i % 13);
+    if (i > 3) fprintf(file, "f -1 -2 -4\n");
+  }
+  long size = ftell(file);
+  fclose(file);
+  for (int mode = READ_MMAP; mode <= READ_BUFFERED; mode++) {
+    progress_log log = {0};
+    parser_options options = {0};
+    options.read_mode = mode;
+    options.progress = log_progress;
+    options.progress_context = &log;
+    data_object data_obj = {0};
+    ck_assert_int_eq(parse_obj(file_name, &data_obj, &options), OK);
+    ck_assert(log.calls > 1);
+    ck_assert_int_eq(log.last_done, size);
+    ck_assert_int_eq(log.total, size);
+    progress_log cancel = {0, 0, 0, 2};
+    options.progress_context = &cancel;
+    vertex_t *vertices = data_obj.vertex_array.matrix;
+    ck_assert_int_eq(parse_obj(file_name, &data_obj, &options), ERROR);
+    ck_assert_int_eq(cancel.calls, 2);
+    ck_assert(cancel.last_done < (size_t)size);
+    ck_assert_ptr_eq(data_obj.vertex_array.matrix, vertices);
+    ck_assert_int_eq(data_obj.vertex_count, 100000);
+    memory_free(&data_obj);
+  }
+  remove(file_name);
+}
+END_TEST
+
+START_TEST(get_polygon_test) {
+  data_object data_obj = {0};
+  ck_assert_int_eq(parser("../Obj/cube.obj", &data_obj), OK);
+  ck_assert_int_eq(data_obj.offset_array[0], 0);
+  ck_assert_int_eq(data_obj.offset_array[data_obj.polygon_count],
+                   data_obj.all_edges_count);
+  size_t total = 0;
+  for (size_t i = 0; i < data_obj.polygon_count; i++) {
+    polygon_t polygon = get_polygon(&data_obj, i);
+    ck_assert_ptr_eq(polygon.polygon, data_obj.index_array + total);
+    total += polygon.colums;
+  }
+  ck_assert_int_eq(total, data_obj.all_edges_count);
+  polygon_t missing = get_polygon(&data_obj, data_obj.polygon_count);
+  ck_assert_ptr_null(missing.polygon);
+  ck_assert_int_eq(missing.colums, 0);
+  memory_free(&data_obj);
+  ck_assert_ptr_null(data_obj.index_array);
+  ck_assert_ptr_null(data_obj.offset_array);
+}
+END_TEST
+
+START_TEST(bounding_box_test) {
+  data_object data_obj = {0};
+  ck_assert_int_eq(parser("../Obj/cube.obj", &data_obj), OK);
+  for (int i = 0; i < 3; i++) {
+    ck_assert_double_eq(data_obj.bbox_min[i], -1);
+    ck_assert_double_eq(data_obj.bbox_max[i], 1);
+    ck_assert_double_eq(data_obj.centroid[i], 0);
+  }
+  ck_assert_double_eq(model_extent(&data_obj), 1);
+  char *file_name = "bbox.obj";
+  FILE *file = fopen(file_name, "w");
+  fprintf(file, "v 1 -7.5 2\nv 3 0.5 -4\nv 2 1 3\nf 1 2 3\n");
+  fclose(file);
+  ck_assert_int_eq(parser(file_name, &data_obj), OK);
+  ck_assert_double_eq(data_obj.bbox_min[0], 1);
+  ck_assert_double_eq(data_obj.bbox_max[0], 3);
+  ck_assert_double_eq(data_obj.bbox_min[1], -7.5);
+  ck_assert_double_eq(data_obj.bbox_max[1], 1);
+  ck_assert_double_eq(data_obj.bbox_min[2], -4);
+  ck_assert_double_eq(data_obj.bbox_max[2], 3);
+  ck_assert_double_eq(data_obj.centroid[0], 2);
+  ck_assert_double_eq(data_obj.centroid[1], -2);
+  ck_assert_double_eq(data_obj.centroid[2], 1.0 / 3.0);
+  ck_assert_double_eq(model_extent(&data_obj), 7.5);
+  memory_reset(&data_obj);
+  ck_assert_double_eq(data_obj.bbox_max[0], 0);
+  ck_assert_double_eq(model_extent(&data_obj), 1);
+  ck_assert_double_eq(model_extent(NULL), 1);
+  memory_free(&data_obj);
+  remove(file_name);
+}
+END_TEST
+
 Suite *s21_parser_Tests(void) {
   Suite *s = suite_create("\033[42m-=s21_parser test=-\033[0m");
   TCase *t = tcase_create("main tcase");
@@ -195,6 +381,12 @@ Suite *s21_parser_Tests(void) {
   tcase_add_test(t, create_matrix_error_test);
   tcase_add_test(t, parser_error_test);
   tcase_add_test(t, parser_matrix_creation_error_test);
+  tcase_add_test(t, parse_obj_read_modes_test);
+  tcase_add_test(t, parser_no_trailing_newline_test);
+  tcase_add_test(t, parse_obj_threads_test);
+  tcase_add_test(t, get_polygon_test);
+  tcase_add_test(t, parse_obj_progress_test);
+  tcase_add_test(t, bounding_box_test);
 
   suite_add_tcase(s, t);
   return s;
@@ -0,0 +1,106 @@
+#include "s21_3DViever_Tests.h"
+
+#define QUANTIZE_TEST_DIR "quantize_test_dir"
+
+static void check_quantized(const data_object *parsed,
+                            const data_object *quantized) {
+  ck_assert_ptr_null(quantized->vertex_array.matrix);
+  ck_assert_ptr_nonnull(quantized->quantized.positions);
+  ck_assert_int_eq(quantized->vertex_count, parsed->vertex_count);
+  ck_assert_int_eq(quantized->polygon_count, parsed->polygon_count);
+  ck_assert_int_eq(memcmp(quantized->offset_array, parsed->offset_array,
+                          (parsed->polygon_count + 1) * sizeof(size_t)),
+                   0);
+  ck_assert_int_eq(memcmp(quantized->index_array, parsed->index_array,
+                          parsed->all_edges_count * sizeof(unsigned int)),
+                   0);
+  double error = 0;
+  for (size_t i = 1; i <= parsed->vertex_count; i++) {
+    double original[3], decoded[3];
+    get_vertex(parsed, i, original);
+    get_vertex(quantized, i, decoded);
+    for (int k = 0; k < 3; k++) {
+      double difference = fabs(original[k] - decoded[k]);
+      ck_assert_double_le(difference,
+                          quantized->quantized.step[k] / 2 + 1e-12);
+      if (difference > error) error = difference;
+    }
+  }
+  ck_assert_double_eq_tol(quantized->quantized.max_error, error, 1e-12);
+  ck_assert_int_lt(model_memory(quantized), model_memory(parsed));
+}
+
+START_TEST(test_quantize_object) {
+  data_object parsed = {0}, quantized = {0};
+  ck_assert_int_eq(parser("../Obj/teapot.obj", &parsed), OK);
+  ck_assert_int_eq(parser("../Obj/teapot.obj", &quantized), OK);
+  ck_assert_int_eq(quantize_object(&quantized), OK);
+  check_quantized(&parsed, &quantized);
+  double xyz[3] = {1, 1, 1};
+  get_vertex(&quantized, 0, xyz);
+  ck_assert_double_eq(xyz[0], 0);
+  get_vertex(&quantized, quantized.vertex_count + 1, xyz);
+  ck_assert_double_eq(xyz[2], 0);
+  vertex_soa soa;
+  ck_assert_int_eq(soa_load(&quantized, &soa), ERROR);
+  ck_assert_int_eq(quantize_object(&quantized), ERROR);
+  ck_assert_int_eq(quantize_object(NULL), ERROR);
+  ck_assert_int_eq(parser("../Obj/cube.obj", &quantized), OK);
+  ck_assert_ptr_null(quantized.quantized.positions);
+  ck_assert_ptr_nonnull(quantized.vertex_array.matrix);
+  memory_free(&parsed);
+  memory_free(&quantized);
+}
+END_TEST
+
+START_TEST(test_quantize_cached) {
+  if (system("rm -rf " QUANTIZE_TEST_DIR) != 0) printf("rm failed\n");
+  parser_options options = {0};
+  options.cache_dir = QUANTIZE_TEST_DIR;
+  data_object parsed = {0}, quantized = {0};
+  int from_cache = -1;
+  ck_assert_int_eq(load_obj("../Obj/cube.obj", &parsed, &options, &from_cache),
+                   OK);
+  ck_assert_int_eq(
+      load_obj("../Obj/cube.obj", &quantized, &options, &from_cache), OK);
+  ck_assert_int_eq(from_cache, 1);
+  ck_assert_ptr_nonnull(quantized.mapping);
+  ck_assert_int_eq(quantize_object(&quantized), OK);
+  ck_assert_ptr_null(quantized.mapping);
+  check_quantized(&parsed, &quantized);
+  memory_free(&parsed);
+  memory_free(&quantized);
+  if (system("rm -rf " QUANTIZE_TEST_DIR) != 0) printf("rm failed\n");
+}
+END_TEST
+
+START_TEST(test_quantize_flat) {
+  data_object data_obj = {0};
+  const char *file_name = "quantize_flat.obj";
+  FILE *file = fopen(file_name, "w");
+  fputs("v 1 2 3\nv 4 2 3\nv 4 5 3\nf 1 2 3\n", file);
+  fclose(file);
+  ck_assert_int_eq(parser(file_name, &data_obj), OK);
+  ck_assert_int_eq(quantize_object(&data_obj), OK);
+  ck_assert_double_eq(data_obj.quantized.step[2], 1);
+  double xyz[3];
+  get_vertex(&data_obj, 3, xyz);
+  ck_assert_double_eq(xyz[0], 4);
+  ck_assert_double_eq(xyz[1], 5);
+  ck_assert_double_eq(xyz[2], 3);
+  ck_assert_double_eq(data_obj.quantized.max_error, 0);
+  memory_free(&data_obj);
+  remove(file_name);
+}
+END_TEST
+
+Suite *s21_quantize_Tests() {
+  Suite *s = suite_create("\033[42m-=s21_quantize test=-\033[0m");
+  TCase *t = tcase_create("main tcase");
+  tcase_add_test(t, test_quantize_object);
+  tcase_add_test(t, test_quantize_cached);
+  tcase_add_test(t, test_quantize_flat);
+
+  suite_add_tcase(s, t);
+  return s;
+}
@@ -27,6 +27,84 @@ START_TEST(test_scale) {
   free_data_object(data_obj);
 }
 
+START_TEST(test_model_matrix) {
+  data_object vertices = {0}, original = {0};
+  ck_assert_int_eq(parser("../Obj/cube.obj", &vertices), OK);
+  ck_assert_int_eq(parser("../Obj/cube.obj", &original), OK);
+  double matrix[16];
+  model_identity(matrix);
+  move_x(&vertices, 0.5, 0);
+  model_move(matrix, 0.5, 0, 0);
+  rotate_x(&vertices, 30, 0);
+  model_rotate_x(matrix, 30);
+  scale(&vertices, 75, 50);
+  model_scale(matrix, 75.0 / 50.0);
+  rotate_y(&vertices, 10, 30);
+  model_rotate_y(matrix, 10 - 30);
+  move_z(&vertices, -2, 0);
+  model_move(matrix, 0, 0, -2);
+  rotate_z(&vertices, 45, 0);
+  model_rotate_z(matrix, 45);
+  move_y(&vertices, 1, 0);
+  model_move(matrix, 0, 1, 0);
+  for (size_t i = 1; i <= original.vertex_count; i++) {
+    double point[3];
+    for (int j = 0; j < 3; j++)
+      point[j] = original.vertex_array.matrix[i * 3 + j];
+    model_transform(matrix, point, point);
+    for (int j = 0; j < 3; j++)
+      ck_assert_double_eq_tol(point[j], vertices.vertex_array.matrix[i * 3 + j],
+                              1e-5);
+  }
+  model_identity(matrix);
+  model_rotate_z(matrix, 90);
+  double point[3] = {1, 0, 0};
+  model_transform(matrix, point, point);
+  ck_assert_double_eq_tol(point[0], 0, 1e-15);
+  ck_assert_double_eq_tol(point[1], 1, 1e-15);
+  ck_assert_double_eq_tol(point[2], 0, 1e-15);
+  memory_free(&vertices);
+  memory_free(&original);
+}
+END_TEST
+
+START_TEST(test_affine_parallel) {
+  size_t count = 200003;
+  data_object *serial = initialize_data_object(count);
+  data_object *threaded = initialize_data_object(count);
+  for (int parallel = 0; parallel < 2; parallel++) {
+    data_object *data_obj = parallel ? threaded : serial;
+    affine_set_parallel(parallel ? 3 : 1, 1000);
+    move_x(data_obj, 0.25, 0);
+    move_y(data_obj, -1.5, 0);
+    move_z(data_obj, 3, 1);
+    rotate_x(data_obj, 33, 0);
+    rotate_y(data_obj, -12, 5);
+    rotate_z(data_obj, 71, 0);
+    scale(data_obj, 3, 7);
+  }
+  affine_set_parallel(0, 0);
+  ck_assert_int_eq(memcmp(serial->vertex_array.matrix,
+                          threaded->vertex_array.matrix,
+                          (count + 1) * 3 * sizeof(vertex_t)),
+                   0);
+  ck_assert_double_eq(threaded->vertex_array.matrix[0], 0);
+  ck_assert_double_ne(threaded->vertex_array.matrix[count * 3], (double)count);
+  free_data_object(serial);
+  free_data_object(threaded);
+}
+END_TEST
+
+Suite *s21_model_Tests() {
+  Suite *s = suite_create("\033[42m-=s21_model test=-\033[0m");
+  TCase *t = tcase_create("main tcase");
+  tcase_add_test(t, test_model_matrix);
+  tcase_add_test(t, test_affine_parallel);
+
+  suite_add_tcase(s, t);
+  return s;
+}
+
 Suite *s21_rotate_x_Tests() {
   Suite *s = suite_create("\033[42m-=s21_rotate_x test=-\033[0m");
   TCase *t = tcase_create("main tcase");
@@ -0,0 +1,113 @@
+#include <locale.h>
+
+#include "s21_3DViever_Tests.h"
+
+static double scan(const char *str) {
+  double value = 0;
+  const char *pos = str;
+  ck_assert_int_eq(scan_double(&pos, str + strlen(str), &value), OK);
+  return value;
+}
+
+START_TEST(test_scan_double) {
+  ck_assert_double_eq(scan("1"), 1.0);
+  ck_assert_double_eq(scan("  -2.5"), -2.5);
+  ck_assert_double_eq(scan("+0.125"), 0.125);
+  ck_assert_double_eq(scan(".5"), 0.5);
+  ck_assert_double_eq(scan("3."), 3.0);
+  ck_assert_double_eq(scan("1e3"), 1000.0);
+  ck_assert_double_eq(scan("-1.5E-2"), -0.015);
+  ck_assert(signbit(scan("-0.0")));
+}
+END_TEST
+
+START_TEST(test_scan_double_exact) {
+  const char *samples[] = {"0.1",
+                           "0.30000000000000004",
+                           "123456.789012",
+                           "-0.000001234567",
+                           "9007199254740993",
+                           "1.7976931348623157e308",
+                           "4.9e-324",
+                           "2.2250738585072014e-308",
+                           "0.1234567890123456789012345",
+                           "1e-400",
+                           "-7.50000000000000000000000001e-1",
+                           NULL};
+  for (const char **str = samples; *str; str++)
+    ck_assert_double_eq(scan(*str), strtod(*str, NULL));
+  srand(21);
+  for (int i = 0; i < 10000; i++) {
+    char str[64];
+    snprintf(str, sizeof(str), "%.*g", 1 + rand() % 17,
+             (rand() - RAND_MAX / 2) * pow(10, rand() % 40 - 20) / 7.0);
+    ck_assert_double_eq(scan(str), strtod(str, NULL));
+  }
+}
+END_TEST
+
+START_TEST(test_scan_double_locale) {
+  const char *old = setlocale(LC_NUMERIC, NULL);
+  char saved[64];
+  snprintf(saved, sizeof(saved), "%s", old ? old : "C");
+  if (setlocale(LC_NUMERIC, "de_DE.UTF-8") ||
+      setlocale(LC_NUMERIC, "ru_RU.UTF-8")) {
+    ck_assert_double_eq(scan("1.5"), 1.5);
+    ck_assert_double_eq(scan("1.00000000000000000000001e-30"), 1e-30);
+  }
+  setlocale(LC_NUMERIC, saved);
+}
+END_TEST
+
+START_TEST(test_scan_double_bounds) {
+  const char *str = "12.5e3";
+  const char *pos = str;
+  double value = 0;
+  ck_assert_int_eq(scan_double(&pos, str + 2, &value), OK);
+  ck_assert_double_eq(value, 12.0);
+  ck_assert_ptr_eq(pos, str + 2);
+  pos = str;
+  ck_assert_int_eq(scan_double(&pos, str, &value), ERROR);
+  str = "1.5x";
+  pos = str;
+  ck_assert_int_eq(scan_double(&pos, str + 4, &value), ERROR);
+  ck_assert_ptr_eq(pos, str);
+}
+END_TEST
+
+START_TEST(test_scan_face_vertex) {
+  const char *str = " 7 -3/2 12/5/9 4//6 8/ 1/x";
+  const char *pos = str, *end = str + strlen(str);
+  long v = 0, vt = 0, vn = 0;
+  ck_assert_int_eq(scan_face_vertex(&pos, end, &v, &vt, &vn), OK);
+  ck_assert_int_eq(v, 7);
+  ck_assert_int_eq(vt, 0);
+  ck_assert_int_eq(scan_face_vertex(&pos, end, &v, &vt, &vn), OK);
+  ck_assert_int_eq(v, -3);
+  ck_assert_int_eq(vt, 2);
+  ck_assert_int_eq(scan_face_vertex(&pos, end, &v, &vt, &vn), OK);
+  ck_assert_int_eq(v, 12);
+  ck_assert_int_eq(vt, 5);
+  ck_assert_int_eq(vn, 9);
+  ck_assert_int_eq(scan_face_vertex(&pos, end, &v, &vt, &vn), OK);
+  ck_assert_int_eq(v, 4);
+  ck_assert_int_eq(vt, 0);
+  ck_assert_int_eq(vn, 6);
+  ck_assert_int_eq(scan_face_vertex(&pos, end, &v, NULL, NULL), OK);
+  ck_assert_int_eq(v, 8);
+  ck_assert_int_eq(scan_face_vertex(&pos, end, &v, NULL, NULL), ERROR);
+}
+END_TEST
+
+Suite *s21_scanner_Tests() {
+  Suite *s = suite_create("\033[42m-=s21_scanner test=-\033[0m");
+  TCase *t = tcase_create("main tcase");
+  tcase_add_test(t, test_scan_double);
+  tcase_add_test(t, test_scan_double_exact);
+  tcase_add_test(t, test_scan_double_locale);
+  tcase_add_test(t, test_scan_double_bounds);
+  tcase_add_test(t, test_scan_face_vertex);
+
+  suite_add_tcase(s, t);
+  return s;
+}
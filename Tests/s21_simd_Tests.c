@@ -0,0 +1,119 @@
+#include "s21_3DViever_Tests.h"
+
+static void fill_object(data_object *data_obj, size_t count) {
+  create_matrix(count + 1, 3, &data_obj->vertex_array);
+  data_obj->vertex_count = count;
+  for (size_t i = 3; i < (count + 1) * 3; i++)
+    data_obj->vertex_array.matrix[i] = (double)(i * 37 % 101) / 7.0 - 5.0;
+}
+
+static void run_kernels(vertex_soa *soa, const double *matrix) {
+  soa_move(soa, 0.5, -1.25, 2);
+  soa_rotate_x(soa, 30);
+  soa_rotate_y(soa, -45);
+  soa_rotate_z(soa, 10);
+  soa_scale(soa, 1.5);
+  soa_transform(soa, matrix);
+}
+
+START_TEST(test_soa_load_store) {
+  data_object data_obj = {0};
+  fill_object(&data_obj, 11);
+  vertex_soa soa;
+  ck_assert_int_eq(soa_load(&data_obj, &soa), OK);
+  ck_assert_int_eq(soa.count, 11);
+  ck_assert_int_eq((size_t)soa.x % 64, 0);
+  ck_assert_int_eq((size_t)soa.y % 64, 0);
+  ck_assert_int_eq((size_t)soa.z % 64, 0);
+  for (size_t i = 0; i < soa.count; i++) {
+    ck_assert_double_eq(soa.x[i], data_obj.vertex_array.matrix[i * 3 + 3]);
+    ck_assert_double_eq(soa.y[i], data_obj.vertex_array.matrix[i * 3 + 4]);
+    ck_assert_double_eq(soa.z[i], data_obj.vertex_array.matrix[i * 3 + 5]);
+  }
+  soa_scale(&soa, 2);
+  double first = data_obj.vertex_array.matrix[3];
+  soa_store(&soa, &data_obj);
+  ck_assert_double_eq(data_obj.vertex_array.matrix[3], first * 2);
+  ck_assert_int_eq(soa_load(NULL, &soa), ERROR);
+  memory_free_matrix(&data_obj.vertex_array);
+  arena_release(&data_obj.arena);
+}
+END_TEST
+
+START_TEST(test_soa_matches_affine) {
+  data_object data_obj = {0};
+  fill_object(&data_obj, 9);
+  vertex_soa soa;
+  ck_assert_int_eq(soa_load(&data_obj, &soa), OK);
+  move_x(&data_obj, 1, 0);
+  move_y(&data_obj, -2, 0);
+  move_z(&data_obj, 0.5, 0);
+  rotate_x(&data_obj, 20, 0);
+  rotate_y(&data_obj, 35, 0);
+  rotate_z(&data_obj, -70, 0);
+  scale(&data_obj, 3, 2);
+  double tolerance = sizeof(vertex_t) == sizeof(double) ? 1e-12 : 1e-5;
+  soa_move(&soa, 1, -2, 0.5);
+  soa_rotate_x(&soa, 20);
+  soa_rotate_y(&soa, 35);
+  soa_rotate_z(&soa, -70);
+  soa_scale(&soa, 1.5);
+  for (size_t i = 0; i < soa.count; i++) {
+    ck_assert_double_eq_tol(soa.x[i], data_obj.vertex_array.matrix[i * 3 + 3],
+                            tolerance);
+    ck_assert_double_eq_tol(soa.y[i], data_obj.vertex_array.matrix[i * 3 + 4],
+                            tolerance);
+    ck_assert_double_eq_tol(soa.z[i], data_obj.vertex_array.matrix[i * 3 + 5],
+                            tolerance);
+  }
+  memory_free_matrix(&data_obj.vertex_array);
+  arena_release(&data_obj.arena);
+}
+END_TEST
+
+START_TEST(test_soa_levels) {
+  int best = simd_set_level(SIMD_AVX2);
+  data_object data_obj = {0};
+  fill_object(&data_obj, 1003);
+  double matrix[16];
+  model_identity(matrix);
+  model_rotate_y(matrix, 15);
+  model_move(matrix, 3, 2, 1);
+  vertex_soa reference, soa;
+  ck_assert_int_eq(soa_load(&data_obj, &reference), OK);
+  ck_assert_int_eq(simd_set_level(SIMD_SCALAR), SIMD_SCALAR);
+  run_kernels(&reference, matrix);
+  for (int level = SIMD_SSE2; level <= best; level++) {
+    ck_assert_int_eq(simd_set_level(level), level);
+    ck_assert_int_eq(simd_level(), level);
+    ck_assert_int_eq(soa_load(&data_obj, &soa), OK);
+    run_kernels(&soa, matrix);
+    ck_assert_int_eq(memcmp(soa.x, reference.x, soa.count * sizeof(double)), 0);
+    ck_assert_int_eq(memcmp(soa.y, reference.y, soa.count * sizeof(double)), 0);
+    ck_assert_int_eq(memcmp(soa.z, reference.z, soa.count * sizeof(double)), 0);
+  }
+  double point[3] = {data_obj.vertex_array.matrix[6],
+                     data_obj.vertex_array.matrix[7],
+                     data_obj.vertex_array.matrix[8]};
+  ck_assert_int_eq(soa_load(&data_obj, &soa), OK);
+  soa_transform(&soa, matrix);
+  model_transform(matrix, point, point);
+  ck_assert_double_eq(soa.x[1], point[0]);
+  ck_assert_double_eq(soa.y[1], point[1]);
+  ck_assert_double_eq(soa.z[1], point[2]);
+  simd_set_level(best);
+  memory_free_matrix(&data_obj.vertex_array);
+  arena_release(&data_obj.arena);
+}
+END_TEST
+
+Suite *s21_simd_Tests() {
+  Suite *s = suite_create("\033[42m-=s21_simd test=-\033[0m");
+  TCase *t = tcase_create("main tcase");
+  tcase_add_test(t, test_soa_load_store);
+  tcase_add_test(t, test_soa_matches_affine);
+  tcase_add_test(t, test_soa_levels);
+
+  suite_add_tcase(s, t);
+  return s;
+}
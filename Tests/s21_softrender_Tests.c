@@ -0,0 +1,244 @@
+#include "s21_3DViever_Tests.h"
+
+#define SIZE 100
+
+static const unsigned char line_rgb[3] = {255, 255, 0};
+static const unsigned char point_rgb[3] = {0, 0, 255};
+
+static void load_model(const char *text, data_object *data_obj) {
+  const char *file_name = "softrender_model.obj";
+  FILE *file = fopen(file_name, "w");
+  fputs(text, file);
+  fclose(file);
+  ck_assert_int_eq(parser((char *)file_name, data_obj), OK);
+  ck_assert_int_eq(build_edges(data_obj), OK);
+  remove(file_name);
+}
+
+static render_settings default_settings(void) {
+  render_settings settings = {SIZE,      SIZE,      0,         1,    0, 1, 1,
+                              {1, 1, 0}, {0, 0, 1}, {0, 0, 0}, NULL, 1};
+  return settings;
+}
+
+static int pixel_is(const unsigned char *pixels, int row, int col,
+                    const unsigned char *rgb) {
+  const unsigned char *pixel = pixels + ((size_t)row * SIZE + col) * 4;
+  return pixel[0] == rgb[0] && pixel[1] == rgb[1] && pixel[2] == rgb[2] &&
+         pixel[3] == 255;
+}
+
+static int count_color(const unsigned char *pixels, const unsigned char *rgb) {
+  int count = 0;
+  for (int row = 0; row < SIZE; row++)
+    for (int col = 0; col < SIZE; col++)
+      count += pixel_is(pixels, row, col, rgb);
+  return count;
+}
+
+START_TEST(test_soft_render_background) {
+  data_object data_obj = {0};
+  unsigned char pixels[SIZE * SIZE * 4];
+  render_settings settings = default_settings();
+  settings.background_color[0] = 0.5;
+  settings.background_color[2] = 2;
+  ck_assert_int_eq(soft_render(&data_obj, &settings, pixels), OK);
+  const unsigned char background[3] = {128, 0, 255};
+  ck_assert_int_eq(count_color(pixels, background), SIZE * SIZE);
+  ck_assert_int_eq(soft_render(NULL, &settings, pixels), ERROR);
+  ck_assert_int_eq(soft_render(&data_obj, NULL, pixels), ERROR);
+  ck_assert_int_eq(soft_render(&data_obj, &settings, NULL), ERROR);
+  settings.width = 0;
+  ck_assert_int_eq(soft_render(&data_obj, &settings, pixels), ERROR);
+}
+END_TEST
+
+START_TEST(test_soft_render_line) {
+  data_object data_obj = {0};
+  unsigned char pixels[SIZE * SIZE * 4];
+  render_settings settings = default_settings();
+  load_model("v -0.5 0 0\nv 0.5 0 0\nf 1 2\n", &data_obj);
+  ck_assert_int_eq(soft_render(&data_obj, &settings, pixels), OK);
+  // Концы в 27.27 и 72.73 по X, строка 50 снизу, последний пиксель не рисуется
+  ck_assert_int_eq(count_color(pixels, line_rgb), 46);
+  for (int col = 27; col <= 72; col++)
+    ck_assert(pixel_is(pixels, 49, col, line_rgb));
+  ck_assert(!pixel_is(pixels, 49, 26, line_rgb));
+  ck_assert(!pixel_is(pixels, 49, 73, line_rgb));
+  settings.thickness = 3;
+  ck_assert_int_eq(soft_render(&data_obj, &settings, pixels), OK);
+  ck_assert_int_eq(count_color(pixels, line_rgb), 46 * 3);
+  ck_assert(pixel_is(pixels, 48, 40, line_rgb));
+  ck_assert(pixel_is(pixels, 50, 40, line_rgb));
+  settings.thickness = 1;
+  settings.type_line = 0;
+  ck_assert_int_eq(soft_render(&data_obj, &settings, pixels), OK);
+  // glLineStipple(2, 0x00FF): 16 пикселей линии, 16 пропуска
+  ck_assert_int_eq(count_color(pixels, line_rgb), 30);
+  ck_assert(pixel_is(pixels, 49, 42, line_rgb));
+  ck_assert(!pixel_is(pixels, 49, 43, line_rgb));
+  ck_assert(!pixel_is(pixels, 49, 58, line_rgb));
+  ck_assert(pixel_is(pixels, 49, 59, line_rgb));
+  memory_free(&data_obj);
+}
+END_TEST
+
+START_TEST(test_soft_render_points) {
+  data_object data_obj = {0};
+  unsigned char pixels[SIZE * SIZE * 4];
+  render_settings settings = default_settings();
+  load_model("v 0 0 0\nv 0.5 0.5 0\n", &data_obj);
+  settings.type_point = 2;
+  settings.size_points = 3;
+  ck_assert_int_eq(soft_render(&data_obj, &settings, pixels), OK);
+  ck_assert_int_eq(count_color(pixels, point_rgb), 2 * 9);
+  for (int row = 48; row <= 50; row++)
+    for (int col = 49; col <= 51; col++)
+      ck_assert(pixel_is(pixels, row, col, point_rgb));
+  settings.size_points = 4;
+  ck_assert_int_eq(soft_render(&data_obj, &settings, pixels), OK);
+  ck_assert_int_eq(count_color(pixels, point_rgb), 2 * 16);
+  ck_assert(pixel_is(pixels, 48, 48, point_rgb));
+  ck_assert(pixel_is(pixels, 51, 51, point_rgb));
+  settings.type_point = 1;
+  settings.size_points = 10;
+  ck_assert_int_eq(soft_render(&data_obj, &settings, pixels), OK);
+  int round_pixels = count_color(pixels, point_rgb);
+  ck_assert_int_gt(round_pixels, 2 * 60);
+  ck_assert_int_lt(round_pixels, 2 * 100);
+  ck_assert(!pixel_is(pixels, 45, 45, point_rgb));
+  ck_assert(pixel_is(pixels, 49, 50, point_rgb));
+  memory_free(&data_obj);
+}
+END_TEST
+
+START_TEST(test_soft_render_depth) {
+  data_object data_obj = {0};
+  unsigned char pixels[SIZE * SIZE * 4];
+  render_settings settings = default_settings();
+  settings.type_point = 2;
+  load_model("v 0 -0.5 0.5\nv 0 0.5 0.5\nv 0 0 -0.5\nf 1 2\n", &data_obj);
+  ck_assert_int_eq(soft_render(&data_obj, &settings, pixels), OK);
+  // Точка за линией закрыта ей
+  ck_assert(pixel_is(pixels, 49, 50, line_rgb));
+  memory_free(&data_obj);
+  load_model("v 0 -0.5 0.5\nv 0 0.5 0.5\nv 0 0 0.9\nf 1 2\n", &data_obj);
+  ck_assert_int_eq(soft_render(&data_obj, &settings, pixels), OK);
+  ck_assert(pixel_is(pixels, 49, 50, point_rgb));
+  memory_free(&data_obj);
+}
+END_TEST
+
+START_TEST(test_soft_render_clipping) {
+  data_object data_obj = {0};
+  unsigned char pixels[SIZE * SIZE * 4];
+  render_settings settings = default_settings();
+  settings.projection = 1;
+  settings.type_point = 2;
+  load_model("v -5 0 0\nv 5 0 0\nv 0 1 3\nv 0 -1 3\nf 1 2\nf 3 4\n",
+             &data_obj);
+  ck_assert_int_eq(soft_render(&data_obj, &settings, pixels), OK);
+  // Первая линия обрезана по краям окна, вторая и все точки позади камеры
+  ck_assert_int_eq(count_color(pixels, line_rgb), SIZE);
+  ck_assert_int_eq(count_color(pixels, point_rgb), 0);
+  for (int col = 0; col < SIZE; col++)
+    ck_assert(pixel_is(pixels, 49, col, line_rgb));
+  memory_free(&data_obj);
+}
+END_TEST
+
+START_TEST(test_soft_render_quantized) {
+  data_object data_obj = {0};
+  unsigned char *full = malloc(SIZE * SIZE * 4);
+  unsigned char *quantized = malloc(SIZE * SIZE * 4);
+  double matrix[16];
+  model_identity(matrix);
+  model_rotate_x(matrix, 30);
+  model_rotate_y(matrix, 20);
+  render_settings settings = default_settings();
+  settings.projection = 1;
+  settings.model_matrix = matrix;
+  ck_assert_int_eq(parser("../Obj/cube.obj", &data_obj), OK);
+  settings.extent = model_extent(&data_obj);
+  ck_assert_int_eq(soft_render(&data_obj, &settings, full), OK);
+  ck_assert_int_gt(count_color(full, line_rgb), 100);
+  ck_assert_int_eq(build_edges(&data_obj), OK);
+  ck_assert_int_eq(quantize_object(&data_obj), OK);
+  ck_assert_int_eq(soft_render(&data_obj, &settings, quantized), OK);
+  int different = 0;
+  for (size_t i = 0; i < SIZE * SIZE * 4; i++)
+    different += full[i] != quantized[i];
+  ck_assert_int_lt(different, SIZE * SIZE * 4 / 100);
+  memory_free(&data_obj);
+  free(full);
+  free(quantized);
+}
+END_TEST
+
+START_TEST(test_soft_render_short_line) {
+  data_object data_obj = {0};
+  unsigned char pixels[SIZE * SIZE * 4];
+  render_settings settings = default_settings();
+  // Концы в 10.2 и 10.4 по X: между ними нет центра пикселя
+  load_model("v -0.8756 0 0\nv -0.8712 0 0\nf 1 2\n", &data_obj);
+  for (int threads = 1; threads <= 2; threads++) {
+    settings.threads = threads;
+    ck_assert_int_eq(soft_render(&data_obj, &settings, pixels), OK);
+    ck_assert_int_eq(count_color(pixels, line_rgb), 0);
+  }
+  memory_free(&data_obj);
+}
+END_TEST
+
+START_TEST(test_soft_render_threads) {
+  data_object data_obj = {0};
+  int width = 300, height = 200;
+  unsigned char *single = malloc(width * height * 4);
+  unsigned char *tiled = malloc(width * height * 4);
+  double matrix[16];
+  model_identity(matrix);
+  model_rotate_x(matrix, 25);
+  model_rotate_y(matrix, 40);
+  model_scale(matrix, 1.5);
+  ck_assert_int_eq(parser("../Obj/cat.obj", &data_obj), OK);
+  ck_assert_int_eq(build_edges(&data_obj), OK);
+  render_settings settings = default_settings();
+  settings.width = width;
+  settings.height = height;
+  settings.model_matrix = matrix;
+  settings.extent = model_extent(&data_obj);
+  for (int style = 0; style < 4; style++) {
+    settings.projection = style % 2;
+    settings.type_line = style / 2;
+    settings.type_point = style % 3;
+    settings.thickness = style + 1;
+    settings.size_points = 2 * style + 1;
+    settings.threads = 1;
+    ck_assert_int_eq(soft_render(&data_obj, &settings, single), OK);
+    for (int threads = 2; threads <= 4; threads += 2) {
+      settings.threads = threads;
+      ck_assert_int_eq(soft_render(&data_obj, &settings, tiled), OK);
+      ck_assert_int_eq(memcmp(single, tiled, width * height * 4), 0);
+    }
+  }
+  memory_free(&data_obj);
+  free(single);
+  free(tiled);
+}
+END_TEST
+
+Suite *s21_softrender_Tests() {
+  Suite *s = suite_create("\033[42m-=s21_softrender test=-\033[0m");
+  TCase *t = tcase_create("main tcase");
+  tcase_add_test(t, test_soft_render_background);
+  tcase_add_test(t, test_soft_render_line);
+  tcase_add_test(t, test_soft_render_points);
+  tcase_add_test(t, test_soft_render_depth);
+  tcase_add_test(t, test_soft_render_clipping);
+  tcase_add_test(t, test_soft_render_quantized);
+  tcase_add_test(t, test_soft_render_short_line);
+  tcase_add_test(t, test_soft_render_threads);
+
+  suite_add_tcase(s, t);
+  return s;
+}